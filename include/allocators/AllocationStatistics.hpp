@@ -0,0 +1,78 @@
+//
+//  AllocationStatistics.hpp
+//  MemoryManagement
+//
+
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+
+// Point in time view of a store
+struct AllocationSnapshot {
+    size_t allocations{0};
+    size_t deallocations{0};
+    size_t live{0};
+    size_t high_water_mark{0};
+    size_t blocks_reserved{0};
+    size_t free_list_length{0};
+};
+
+// Statistics policy that collects nothing, every hook compiles away
+struct NoStatistics {
+    constexpr static const bool ENABLED = false;
+    void onAllocate(size_t count = 1){}
+    void onDeallocate(size_t count = 1){}
+    size_t allocations() const { return 0; }
+    size_t deallocations() const { return 0; }
+};
+
+// Statistics policy with relaxed counters sharded by thread, so stores used from many threads
+// do not contend on a single counter line. Reads sum the shards and are approximate while
+// other threads are allocating.
+class AllocationStatistics {
+public:
+
+    constexpr static const bool ENABLED = true;
+    constexpr static const size_t SHARDS = 16;
+
+    void onAllocate(size_t count = 1){ shard().allocations.fetch_add(count, std::memory_order_relaxed); }
+    void onDeallocate(size_t count = 1){ shard().deallocations.fetch_add(count, std::memory_order_relaxed); }
+
+    size_t allocations() const {
+        size_t total = 0;
+        for(auto& shard : mShards){ total += shard.allocations.load(std::memory_order_relaxed); }
+        return total;
+    }
+
+    size_t deallocations() const {
+        size_t total = 0;
+        for(auto& shard : mShards){ total += shard.deallocations.load(std::memory_order_relaxed); }
+        return total;
+    }
+
+private:
+
+    struct Shard {
+        std::atomic<size_t> allocations{0};
+        std::atomic<size_t> deallocations{0};
+        char pad[64 - 2 * sizeof(std::atomic<size_t>)];
+    };
+
+    Shard& shard(){ return mShards[threadShard()]; }
+
+    static size_t threadShard(){
+        static std::atomic<size_t> sNext{0};
+        thread_local size_t tShard = sNext.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+        return tShard;
+    }
+
+    Shard mShards[SHARDS];
+};
+
+// Define ALLOCATOR_STATISTICS to collect statistics in every store that uses the default
+#if defined(ALLOCATOR_STATISTICS)
+typedef AllocationStatistics DefaultStatistics;
+#else
+typedef NoStatistics DefaultStatistics;
+#endif
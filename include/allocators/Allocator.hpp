@@ -34,6 +34,12 @@ public:
 	
 	FORWARD_ALLOCATOR_TRAITS(Policy)
 	
+	// container propagation follows the policy, see STATELESS_ALLOCATOR_TRAITS
+	typedef typename Policy::propagate_on_container_copy_assignment propagate_on_container_copy_assignment;
+	typedef typename Policy::propagate_on_container_move_assignment propagate_on_container_move_assignment;
+	typedef typename Policy::propagate_on_container_swap propagate_on_container_swap;
+	typedef typename Policy::is_always_equal is_always_equal;
+	
 	template<typename U>
 	struct rebind
 	{
@@ -43,8 +49,9 @@ public:
 		> other;
 	};
 	
+	// arguments go to the allocation policy, e.g. the Arena an ArenaAllocator draws from
 	template<typename...Args>
-	Allocator(Args&&...args) : Policy(std::forward<Args>(args)...), Initailization(std::forward<Args>(args)...) {}
+	Allocator(Args&&...args) : Policy(std::forward<Args>(args)...) {}
 	
 	// Copy Constructor
 	template<typename U,
@@ -58,13 +65,26 @@ public:
 	{}
 };
 
-// Two allocators are not equal unless a specialization says so
+// Policies compare through their own operator==, policies without one never compare equal
+template<typename PolicyT, typename PolicyU>
+auto policies_equal(PolicyT const& left, PolicyU const& right, int) -> decltype(bool(left == right))
+{
+	return left == right;
+}
+
+template<typename PolicyT, typename PolicyU>
+bool policies_equal(PolicyT const&, PolicyU const&, long)
+{
+	return false;
+}
+
+// Equal when memory from one can be freed through the other
 template<typename T, typename AllocationPolicy, typename InitializationPolicy,
 typename U, typename AllocationPolicyU, typename InitializationAllocationPolicyU>
 bool operator==(Allocator<T, AllocationPolicy, InitializationPolicy> const& left,
 				Allocator<U, AllocationPolicyU, InitializationAllocationPolicyU> const& right)
 {
-	return false;
+	return policies_equal(static_cast<AllocationPolicy const&>(left), static_cast<AllocationPolicyU const&>(right), 0);
 }
 
 // Also implement inequality
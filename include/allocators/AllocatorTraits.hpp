@@ -8,6 +8,9 @@
 
 #pragma once
 
+#include <cstddef>
+#include <type_traits>
+
 #define ALLOCATOR_TRAITS(T)                \
 typedef T                 type;            \
 typedef type              value_type;      \
@@ -18,3 +21,18 @@ typedef value_type const& const_reference; \
 typedef std::size_t       size_type;       \
 typedef std::ptrdiff_t    difference_type; \
 
+// Policies with no state: any instance frees what another allocated
+#define STATELESS_ALLOCATOR_TRAITS                                  \
+typedef std::true_type propagate_on_container_copy_assignment;      \
+typedef std::true_type propagate_on_container_move_assignment;      \
+typedef std::true_type propagate_on_container_swap;                 \
+typedef std::true_type is_always_equal;                             \
+
+// Policies pointing at memory they draw from, e.g. an arena or a pool. The allocator travels
+// with the container's memory so moves and swaps steal pointers instead of moving elements.
+#define STATEFUL_ALLOCATOR_TRAITS                                   \
+typedef std::true_type propagate_on_container_copy_assignment;      \
+typedef std::true_type propagate_on_container_move_assignment;      \
+typedef std::true_type propagate_on_container_swap;                 \
+typedef std::false_type is_always_equal;                            \
+
@@ -0,0 +1,129 @@
+//
+//  Arena.hpp
+//  MemoryManagement
+//
+
+#pragma once
+
+#include <new>
+#include "IAllocator.h"
+
+// Where an arena gets its chunks, the global heap unless one is given
+class ChunkSource {
+public:
+    virtual ~ChunkSource() = default;
+    virtual void* allocate_chunk(size_t bytes) = 0;
+    virtual void deallocate_chunk(void* chunk, size_t bytes) = 0;
+};
+
+// Monotonic arena. Allocation bumps a pointer through a chain of chunks and individual frees
+// are no-ops; memory comes back all at once with rewind() to an earlier mark() or with
+// release_all(). Both are O(1) and keep the chunks for reuse, only the destructor frees them.
+class Arena {
+public:
+
+    constexpr static const size_t DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+    // position to rewind to, only valid while the arena has not been rewound past it
+    struct Marker {
+        void* chunk;
+        char* top;
+    };
+
+    explicit Arena(size_t chunkSize = DEFAULT_CHUNK_SIZE, ChunkSource* source = nullptr) :
+    mChunkSize(chunkSize),
+    mSource(source)
+    {}
+
+    ~Arena(){
+        while(mFirst){
+            auto next = mFirst->next;
+            if(mSource){
+                mSource->deallocate_chunk(mFirst, sizeof(Chunk) + mFirst->size);
+            }else{
+                ::operator delete(mFirst);
+            }
+            mFirst = next;
+        }
+    }
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t bytes, size_t alignment = DEFAULT_ALIGNMENT){
+        auto ptr = align(mTop, alignment);
+        if(!mCurrent || ptr + bytes > mCurrent->end()){
+            advance(bytes, alignment);
+            ptr = align(mTop, alignment);
+        }
+        mTop = ptr + bytes;
+        if(used() > mHighWater) mHighWater = used();
+        return ptr;
+    }
+
+    Marker mark() const { return Marker{mCurrent, mTop}; }
+
+    void rewind(Marker marker){
+        if(!marker.chunk){
+            release_all();
+            return;
+        }
+        mCurrent = static_cast<Chunk*>(marker.chunk);
+        mTop = marker.top;
+    }
+
+    void release_all(){
+        mCurrent = mFirst;
+        mTop = mFirst ? mFirst->begin() : nullptr;
+    }
+
+    // bytes handed out since the last release_all, including alignment padding
+    size_t used() const { return mCurrent ? mCurrent->base + (mTop - mCurrent->begin()) : 0; }
+    // bytes held in chunks
+    size_t reserved() const { return mReserved; }
+    size_t high_water_mark() const { return mHighWater; }
+
+private:
+
+    struct Chunk {
+        Chunk* next;
+        size_t size;
+        size_t base;    // bytes in the chunks before this one, set when it becomes current
+        char* begin(){ return reinterpret_cast<char*>(this + 1); }
+        char* end(){ return begin() + size; }
+    };
+
+    static char* align(char* ptr, size_t alignment){
+        return reinterpret_cast<char*>(round_up(reinterpret_cast<uintptr_t>(ptr), alignment));
+    }
+
+    // move to the next chunk that fits, chaining a new one in after the current chunk if needed
+    void advance(size_t bytes, size_t alignment){
+        auto needed = bytes + alignment;
+        auto next = mCurrent ? mCurrent->next : mFirst;
+        if(!next || next->size < needed){
+            auto size = needed > mChunkSize ? needed : mChunkSize;
+            auto chunk = static_cast<Chunk*>(mSource ? mSource->allocate_chunk(sizeof(Chunk) + size) : ::operator new(sizeof(Chunk) + size));
+            chunk->size = size;
+            chunk->next = next;
+            if(mCurrent){
+                mCurrent->next = chunk;
+            }else{
+                mFirst = chunk;
+            }
+            mReserved += size;
+            next = chunk;
+        }
+        next->base = mCurrent ? mCurrent->base + mCurrent->size : 0;
+        mCurrent = next;
+        mTop = next->begin();
+    }
+
+    size_t mChunkSize;
+    ChunkSource* mSource;
+    Chunk* mFirst{nullptr};
+    Chunk* mCurrent{nullptr};
+    char* mTop{nullptr};
+    size_t mReserved{0};
+    size_t mHighWater{0};
+};
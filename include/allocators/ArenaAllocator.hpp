@@ -0,0 +1,58 @@
+//
+//  ArenaAllocator.hpp
+//  MemoryManagement
+//
+
+#pragma once
+
+#include "AllocatorTraits.hpp"
+#include "Arena.hpp"
+
+// Allocation policy drawing from an Arena owned by the caller, e.g. one per request. Containers
+// built on it never free node by node, the whole request is dropped with Arena::rewind or
+// Arena::release_all once the containers are gone.
+template<typename T>
+class ArenaAllocator
+{
+public:
+    
+    ALLOCATOR_TRAITS(T)
+    STATEFUL_ALLOCATOR_TRAITS
+    
+    template<typename U>
+    struct rebind
+    {
+        typedef ArenaAllocator<U> other;
+    };
+    
+    ArenaAllocator(Arena& arena) : mArena(&arena) {}
+    
+    // Copy Constructor, rebound copies share the arena
+    template<typename U>
+    ArenaAllocator(ArenaAllocator<U> const& other) : mArena(other.arena()) {}
+    
+    // Bump allocate count objects
+    pointer allocate(size_type count = 1, const_pointer hint = 0)
+    {
+        if(count > max_size()){throw std::bad_alloc();}
+        return static_cast<pointer>(mArena->allocate(count * sizeof(T), alignof(T)));
+    }
+    
+    // Nothing to do, the arena reclaims everything at once
+    void deallocate(pointer ptr, size_type count = 1) {}
+    
+    // Max number of objects that can be allocated in one call
+    size_type max_size(void) const {return max_allocations<sizeof(T)>::value;}
+    
+    Arena* arena() const { return mArena; }
+    
+private:
+    Arena* mArena;
+};
+
+// Equal when sharing the same arena
+template<typename T, typename U>
+bool operator==(ArenaAllocator<T> const& left, ArenaAllocator<U> const& right)
+{
+    return left.arena() == right.arena();
+}
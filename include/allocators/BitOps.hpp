@@ -0,0 +1,42 @@
+//
+//  BitOps.hpp
+//  MemoryManagement
+//
+
+#pragma once
+
+#include <stdint.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Bit scans used by the histograms and bitmap based allocators. Results are undefined for 0.
+
+inline unsigned count_trailing_zeros(uint64_t value)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctzll(value));
+#endif
+}
+
+inline unsigned count_leading_zeros(uint64_t value)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return 63 - static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_clzll(value));
+#endif
+}
+
+// index of the most significant set bit
+inline unsigned find_last_set(uint64_t value)
+{
+    return 63 - count_leading_zeros(value);
+}
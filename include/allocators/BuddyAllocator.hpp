@@ -0,0 +1,60 @@
+//
+//  BuddyAllocator.hpp
+//  MemoryManagement
+//
+
+#pragma once
+
+#include "AllocatorTraits.hpp"
+#include "BuddyStore.hpp"
+
+// Allocation policy serving any count from a BuddyStore, for variable size buffers between
+// MinBlock and RegionSize bytes. Blocks are aligned to the smaller of their size and a page.
+template<typename T, size_t MinBlock = 1024, size_t RegionSize = 64 * 1024 * 1024>
+class BuddyAllocator
+{
+public:
+    
+    ALLOCATOR_TRAITS(T)
+    STATELESS_ALLOCATOR_TRAITS
+    
+    typedef BuddyStore<MinBlock,RegionSize> store_type;
+    
+    template<typename U>
+    struct rebind
+    {
+        typedef BuddyAllocator<U,MinBlock,RegionSize> other;
+    };
+    
+    // Default Constructor
+    BuddyAllocator() = default;
+    
+    // Copy Constructor
+    template<typename U>
+    BuddyAllocator(BuddyAllocator<U,MinBlock,RegionSize> const& other){}
+    
+    pointer allocate(size_type count = 1, const_pointer hint = 0)
+    {
+        if(count > max_size()){throw std::bad_alloc();}
+        return static_cast<pointer>(store_type::get()->allocate(count * sizeof(T)));
+    }
+    
+    // The block size is kept by the store, count is not needed
+    void deallocate(pointer ptr, size_type count = 1)
+    {
+        store_type::get()->deallocate(ptr);
+    }
+    
+    // Max number of objects that can be allocated in one call
+    size_type max_size(void) const {return RegionSize / sizeof(T);}
+    size_t capacity(){ return store_type::get()->capacity(); }
+    BuddyReport report(){ return store_type::get()->report(); }
+    
+};
+
+// Every instance shares the BuddyStore singleton
+template<typename T, typename U, size_t MinBlock, size_t RegionSize>
+bool operator==(BuddyAllocator<T,MinBlock,RegionSize> const& left, BuddyAllocator<U,MinBlock,RegionSize> const& right)
+{
+    return true;
+}
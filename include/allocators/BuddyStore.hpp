@@ -0,0 +1,203 @@
+//
+//  BuddyStore.hpp
+//  MemoryManagement
+//
+
+#pragma once
+
+#include <cassert>
+#include <memory>
+#include <new>
+#include <vector>
+#include "BitOps.hpp"
+#include "IAllocator.h"
+#include "VirtualMemory.hpp"
+
+// Free space summary, fragmentation is 1 - largest free block / free bytes
+struct BuddyReport {
+    size_t allocatedBytes{0};
+    size_t freeBytes{0};
+    size_t largestFreeBlock{0};
+    double fragmentation{0.0};
+    std::vector<size_t> freeBlocks;     // free blocks per order, order 0 is MinBlock bytes
+};
+
+// Binary buddy allocator over one RegionSize mapping. Requests are rounded up to a power of two
+// no smaller than MinBlock. Each order keeps a doubly linked free list threaded through the free
+// blocks and a bitmap of which blocks are free, so a block's buddy is found and unlinked in O(1)
+// while coalescing. The order of every allocated block lives in a side table, outside the block.
+template<size_t MinBlock, size_t RegionSize>
+class BuddyStore : public IAllocator {
+public:
+
+    static_assert((MinBlock & (MinBlock - 1)) == 0 && MinBlock >= 2 * sizeof(void*), "MinBlock must be a power of two that fits two pointers");
+    static_assert((RegionSize & (RegionSize - 1)) == 0 && RegionSize >= MinBlock, "RegionSize must be a power of two");
+
+    constexpr static const size_t MIN_BLOCK = MinBlock;
+    constexpr static const size_t MAX_ORDER = log2_floor(RegionSize / MinBlock);
+    constexpr static const size_t ORDERS = MAX_ORDER + 1;
+    constexpr static const size_t MIN_BLOCKS = RegionSize / MinBlock;
+
+    static_assert(ORDERS <= 64, "too many orders for the order mask");
+
+    static BuddyStore* get(){
+        if(!sBuddyStore){
+            sBuddyStore.reset(new BuddyStore);
+        }
+        return sBuddyStore.get();
+    }
+
+    ~BuddyStore(){
+        VirtualMemory::release(mRegion, RegionSize);
+    }
+
+    BuddyStore(const BuddyStore&) = delete;
+    BuddyStore& operator=(const BuddyStore&) = delete;
+
+    // bytes, rounded up to a power of two block
+    void* allocate(size_t bytes)override {
+        if(bytes > RegionSize) throw std::bad_alloc();
+        auto order = order_of(bytes);
+        // lowest non empty order that can satisfy the request
+        auto candidates = mNonEmpty >> order;
+        if(!candidates) throw std::bad_alloc();
+        auto found = order + count_trailing_zeros(candidates);
+        auto index = pop(found);
+        // split, keeping the lower half and freeing the upper buddy each step
+        while(found > order){
+            --found;
+            push(index + (size_t(1) << found), found);
+        }
+        mOrders[index] = static_cast<uint8_t>(order);
+        mAllocated += MinBlock << order;
+        return block(index);
+    }
+
+    // nullptr is ignored, anything else must be a block this store handed out
+    void deallocate(void* ptr)override{
+        if(!ptr) return;
+        assert(contains(ptr) && (static_cast<char*>(ptr) - static_cast<char*>(mRegion)) % MinBlock == 0);
+        auto index = index_of(ptr);
+        size_t order = mOrders[index];
+        mAllocated -= MinBlock << order;
+        // merge with the buddy for as long as it is free too
+        while(order < MAX_ORDER){
+            auto buddy = index ^ (size_t(1) << order);
+            if(!is_free(buddy, order)) break;
+            unlink(buddy, order);
+            index &= ~(size_t(1) << order);
+            ++order;
+        }
+        push(index, order);
+    }
+
+    size_t capacity() override { return RegionSize - mAllocated; }
+
+    // bytes actually reserved for a request of bytes
+    static size_t block_size(size_t bytes){ return MinBlock << order_of(bytes); }
+
+    bool contains(const void* ptr) const {
+        return ptr >= mRegion && ptr < static_cast<const char*>(mRegion) + RegionSize;
+    }
+
+    BuddyReport report() const {
+        BuddyReport report;
+        report.allocatedBytes = mAllocated;
+        report.freeBlocks.resize(ORDERS);
+        for(size_t order = 0; order < ORDERS; order++){
+            for(auto node = mFree[order]; node; node = node->next){
+                report.freeBlocks[order]++;
+            }
+            if(report.freeBlocks[order]){
+                report.largestFreeBlock = MinBlock << order;
+            }
+            report.freeBytes += report.freeBlocks[order] * (MinBlock << order);
+        }
+        if(report.freeBytes){
+            report.fragmentation = 1.0 - double(report.largestFreeBlock) / double(report.freeBytes);
+        }
+        return report;
+    }
+
+private:
+
+    struct Node {
+        Node* next;
+        Node* prev;
+    };
+
+    // the region is mapped lazily, so untouched blocks cost nothing
+    BuddyStore() :
+    mRegion(VirtualMemory::map(RegionSize)),
+    mOrders(new uint8_t[MIN_BLOCKS]),
+    mFreeBits(new uint64_t[(bit_offset(ORDERS) + 63) / 64]())
+    {
+        if(!mRegion) throw std::bad_alloc();
+        for(auto& head : mFree){ head = nullptr; }
+        push(0, MAX_ORDER);
+    }
+
+    static size_t order_of(size_t bytes){
+        if(bytes <= MinBlock) return 0;
+        return find_last_set((bytes - 1) / MinBlock) + 1;
+    }
+
+    // first bit of order in the free bitmap, each order has MIN_BLOCKS >> order bits
+    constexpr static size_t bit_offset(size_t order){
+        return order == 0 ? 0 : bit_offset(order - 1) + (MIN_BLOCKS >> (order - 1));
+    }
+
+    size_t bit(size_t index, size_t order) const { return bit_offset(order) + (index >> order); }
+    bool is_free(size_t index, size_t order) const { auto b = bit(index, order); return (mFreeBits[b / 64] >> (b % 64)) & 1; }
+    void set_free(size_t index, size_t order){ auto b = bit(index, order); mFreeBits[b / 64] |= uint64_t(1) << (b % 64); }
+    void clear_free(size_t index, size_t order){ auto b = bit(index, order); mFreeBits[b / 64] &= ~(uint64_t(1) << (b % 64)); }
+
+    char* block(size_t index) const { return static_cast<char*>(mRegion) + index * MinBlock; }
+    size_t index_of(const void* ptr) const { return (static_cast<const char*>(ptr) - static_cast<const char*>(mRegion)) / MinBlock; }
+    Node* node(size_t index) const { return reinterpret_cast<Node*>(block(index)); }
+
+    void push(size_t index, size_t order){
+        auto head = node(index);
+        head->prev = nullptr;
+        head->next = mFree[order];
+        if(head->next) head->next->prev = head;
+        mFree[order] = head;
+        mNonEmpty |= uint64_t(1) << order;
+        set_free(index, order);
+    }
+
+    size_t pop(size_t order){
+        auto head = mFree[order];
+        auto index = index_of(head);
+        unlink(index, order);
+        return index;
+    }
+
+    void unlink(size_t index, size_t order){
+        auto entry = node(index);
+        if(entry->prev){
+            entry->prev->next = entry->next;
+        }else{
+            mFree[order] = entry->next;
+        }
+        if(entry->next) entry->next->prev = entry->prev;
+        if(!mFree[order]) mNonEmpty &= ~(uint64_t(1) << order);
+        clear_free(index, order);
+    }
+
+    void* mRegion;
+    std::unique_ptr<uint8_t[]> mOrders;
+    std::unique_ptr<uint64_t[]> mFreeBits;
+    Node* mFree[ORDERS];
+    uint64_t mNonEmpty{0};
+    size_t mAllocated{0};
+    static std::unique_ptr<BuddyStore> sBuddyStore;
+};
+
+template<size_t MinBlock, size_t RegionSize> constexpr const size_t BuddyStore<MinBlock,RegionSize>::MIN_BLOCK;
+template<size_t MinBlock, size_t RegionSize> constexpr const size_t BuddyStore<MinBlock,RegionSize>::MAX_ORDER;
+template<size_t MinBlock, size_t RegionSize> constexpr const size_t BuddyStore<MinBlock,RegionSize>::ORDERS;
+template<size_t MinBlock, size_t RegionSize> constexpr const size_t BuddyStore<MinBlock,RegionSize>::MIN_BLOCKS;
+
+template<size_t MinBlock, size_t RegionSize>
+std::unique_ptr<BuddyStore<MinBlock,RegionSize>> BuddyStore<MinBlock,RegionSize>::sBuddyStore = nullptr;
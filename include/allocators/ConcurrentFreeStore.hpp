@@ -0,0 +1,134 @@
+//
+//  ConcurrentFreeStore.hpp
+//  MemoryManagement
+//
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include "FreeStore.hpp"
+
+// Free store safe to share between threads. The free list is a lock free Treiber stack whose
+// head packs a version tag next to the pointer so a single 64 bit CAS is immune to ABA.
+// Only carving fresh slots out of the storage takes a lock, and it does so a run at a time.
+template <size_t Size, typename StorageType>
+class ConcurrentFreeStore : public IAllocator{
+public:
+
+    constexpr static const size_t CARVE_COUNT = 32;
+
+    static ConcurrentFreeStore* get(){
+        // function local static, so the first call is safe from any thread
+        static ConcurrentFreeStore sFreeStore;
+        return &sFreeStore;
+    }
+
+    void* allocate(size_t count = 1)override {
+        auto head = mFreeStore.load(std::memory_order_acquire);
+        while(pointer(head)){
+            // the slot may be popped and reused under us, a stale read just fails the CAS
+            auto next = link(pointer(head))->load(std::memory_order_relaxed);
+            if(mFreeStore.compare_exchange_weak(head, pack(next, tag(head) + 1),
+                                                std::memory_order_acquire,
+                                                std::memory_order_acquire)){
+                return pointer(head);
+            }
+        }
+        return carve();
+    }
+
+    void deallocate(void* ptr)override{
+        push(ptr, ptr);
+    }
+
+    // Link the slots together and push them with a single CAS
+    void deallocate_n(void* const* ptrs, size_t count)override{
+        if(count == 0) return;
+        for(size_t i = 0; i < count - 1; i++){
+            link(ptrs[i])->store(ptrs[i + 1], std::memory_order_relaxed);
+        }
+        push(ptrs[0], ptrs[count - 1]);
+    }
+
+    size_t capacity() override {
+        std::lock_guard<std::mutex> lock(mGrowMutex);
+        return mStorage.capacity();
+    }
+
+    size_t max_size(){
+        std::lock_guard<std::mutex> lock(mGrowMutex);
+        return mStorage.max_size();
+    }
+
+private:
+
+    typedef uint64_t tagged_type;
+
+    // user space pointers fit in the low 48 bits on 64 bit targets, the rest holds the tag.
+    // 5 level paging can map above that, so every carved slot is checked with fits().
+    constexpr static const tagged_type POINTER_BITS = sizeof(void*) == 8 ? 48 : 32;
+    constexpr static const tagged_type POINTER_MASK = (tagged_type(1) << POINTER_BITS) - 1;
+
+    // the whole slot is addressable with POINTER_BITS, so packing it loses nothing
+    static bool fits(void* slot){
+        return ((static_cast<tagged_type>(reinterpret_cast<uintptr_t>(slot)) + StorageType::OBJECT_SIZE - 1) >> POINTER_BITS) == 0;
+    }
+
+    static tagged_type pack(void* ptr, tagged_type tag){
+        return (static_cast<tagged_type>(reinterpret_cast<uintptr_t>(ptr)) & POINTER_MASK) | (tag << POINTER_BITS);
+    }
+    static void* pointer(tagged_type tagged){
+        return reinterpret_cast<void*>(static_cast<uintptr_t>(tagged & POINTER_MASK));
+    }
+    static tagged_type tag(tagged_type tagged){
+        return tagged >> POINTER_BITS;
+    }
+    static std::atomic<void*>* link(void* ptr){
+        return reinterpret_cast<std::atomic<void*>*>(ptr);
+    }
+
+    // push an already linked chain of slots in one CAS
+    void push(void* first, void* last){
+        auto head = mFreeStore.load(std::memory_order_relaxed);
+        do{
+            link(last)->store(pointer(head), std::memory_order_relaxed);
+        }while(!mFreeStore.compare_exchange_weak(head, pack(first, tag(head) + 1),
+                                                 std::memory_order_release,
+                                                 std::memory_order_relaxed));
+    }
+
+    // free list is empty, take a run of fresh slots from the storage and keep the first
+    void* carve(){
+        void* slots[CARVE_COUNT];
+        size_t count = 0;
+        {
+            std::lock_guard<std::mutex> lock(mGrowMutex);
+            while(count < CARVE_COUNT){
+                try{
+                    slots[count] = mStorage[mLast];
+                    // memory the tagged head cannot address is as good as none
+                    if(!fits(slots[count])) throw std::bad_alloc();
+                }catch(const std::bad_alloc&){
+                    if(count) break;
+                    throw;
+                }
+                ++mLast;
+                ++count;
+            }
+        }
+        if(count > 1){
+            for(size_t i = 1; i < count - 1; i++){
+                link(slots[i])->store(slots[i + 1], std::memory_order_relaxed);
+            }
+            push(slots[1], slots[count - 1]);
+        }
+        return slots[0];
+    }
+
+    std::atomic<tagged_type> mFreeStore{0};
+    std::mutex mGrowMutex;
+    size_t mLast{0};
+    StorageType mStorage;
+    ConcurrentFreeStore() = default;
+};
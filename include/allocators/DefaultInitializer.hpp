@@ -8,6 +8,8 @@
 
 #pragma once
 
+#include "Relocation.hpp"
+
 template<typename T>
 class DefaultInitializer
 {
@@ -36,13 +38,24 @@ public:
 	template<typename...Args>
 	void construct(type* ptr, Args&&...args)
 	{
-		new(ptr) type(args...);
+		new(ptr) type(std::forward<Args>(args)...);
 	}
 
-	// Destroy object
+	// Destroy object, a no-op for trivially destructible types
 	void destroy(type* ptr)
 	{
-		// Call destructor
-		ptr->~type();
+		::destroy_n(ptr, 1);
+	}
+	
+	// Value initialize count objects, a memset for trivial types
+	void construct_n(type* ptr, size_t count)
+	{
+		::construct_n(ptr, count);
+	}
+	
+	// Destroy count objects, skipped for trivially destructible types
+	void destroy_n(type* ptr, size_t count)
+	{
+		::destroy_n(ptr, count);
 	}
 };
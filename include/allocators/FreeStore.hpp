@@ -7,81 +7,174 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstring>
 #include <stdint.h>
 #include <memory>
+#include <string>
+#include <vector>
 #include "IAllocator.h"
+#include "AllocationStatistics.hpp"
+#include "LatencySample.hpp"
 
 struct InBytes {};
 struct InNumObjects {};
 
-template<size_t Size, size_t MaxSize>
-class FixedSizeStorage {
+// Block memory from the free store, zeroed up front. Block memory policies return blocks
+// aligned to at least the requested alignment, which is never more than a page.
+struct HeapBlocks {
+    static void* allocate(size_t bytes, size_t alignment){
+        auto block = alignment > DEFAULT_ALIGNMENT ? aligned_allocate(bytes, alignment) : ::operator new(bytes);
+        if(!block) throw std::bad_alloc();
+        std::memset(block, 0, bytes);
+        return block;
+    }
+    static void deallocate(void* block, size_t bytes, size_t alignment){
+        if(alignment > DEFAULT_ALIGNMENT){
+            aligned_deallocate(block);
+        }else{
+            ::operator delete(block);
+        }
+    }
+};
+
+template<size_t Size, size_t MaxSize, typename BlockMemory>
+class BasicFixedSizeStorage {
 public:
     
     constexpr static const size_t OBJECT_SIZE = ((Size + sizeof(void *)-1) / sizeof(void *)) * sizeof(void *);
     constexpr static const size_t OBJECTS_PER_BLOCK = MaxSize / OBJECT_SIZE;
     constexpr static const size_t BLOCK_SIZE = OBJECTS_PER_BLOCK * OBJECT_SIZE;
+    constexpr static const size_t OBJECT_ALIGNMENT = slot_alignment(OBJECT_SIZE);
+    // blocks start on a cache line so slot index alone decides which lines a slot touches
+    constexpr static const size_t BLOCK_ALIGNMENT = OBJECT_ALIGNMENT > CACHE_LINE_SIZE ? OBJECT_ALIGNMENT : CACHE_LINE_SIZE;
+    constexpr static const size_t RELEASE_OBJECTS = OBJECTS_PER_BLOCK;
     
-    FixedSizeStorage() :
-    mObjects(::operator new(BLOCK_SIZE))
-    {
-        std::memset(mObjects, 0, BLOCK_SIZE);
-    }
+    BasicFixedSizeStorage() :
+    mObjects(BlockMemory::allocate(BLOCK_SIZE, BLOCK_ALIGNMENT))
+    {}
     
-    ~FixedSizeStorage() {
-        ::operator delete( mObjects );
+    ~BasicFixedSizeStorage() {
+        if(mObjects) BlockMemory::deallocate(mObjects, BLOCK_SIZE, BLOCK_ALIGNMENT);
     }
     
+    BasicFixedSizeStorage(const BasicFixedSizeStorage&) = delete;
+    BasicFixedSizeStorage& operator=(const BasicFixedSizeStorage&) = delete;
+    
     void* operator[](size_t index) {
         if(index >= OBJECTS_PER_BLOCK) throw std::bad_alloc();
+        if(!mObjects){
+            // released by a trim, back it again
+            mObjects = BlockMemory::allocate(BLOCK_SIZE, BLOCK_ALIGNMENT);
+        }
         char * head = reinterpret_cast<char*>(mObjects);
         return reinterpret_cast<void*>(head + (index*OBJECT_SIZE));
     }
     
+    // slots from index to the end of its block, which sit back to back in memory
+    size_t contiguous(size_t index){ return index < OBJECTS_PER_BLOCK ? OBJECTS_PER_BLOCK - index : 0; }
+    
     size_t capacity(){ return OBJECTS_PER_BLOCK; }
     size_t max_size(){ return BLOCK_SIZE; }
+    size_t blocks(){ return mObjects ? 1 : 0; }
+    
+    // the whole block is the unit of trimming
+    size_t release_units(){ return 1; }
+    void* release_base(size_t unit){ return mObjects; }
+    void release(size_t unit){
+        BlockMemory::deallocate(mObjects, BLOCK_SIZE, BLOCK_ALIGNMENT);
+        mObjects = nullptr;
+    }
 
 private:
    void* mObjects;
 };
 
-template<size_t Size, size_t BlockSize>
-class BlockListStorage {
+template<size_t Size, size_t MaxSize, typename BlockMemory> constexpr const size_t BasicFixedSizeStorage<Size,MaxSize,BlockMemory>::OBJECT_SIZE;
+template<size_t Size, size_t MaxSize, typename BlockMemory> constexpr const size_t BasicFixedSizeStorage<Size,MaxSize,BlockMemory>::OBJECTS_PER_BLOCK;
+template<size_t Size, size_t MaxSize, typename BlockMemory> constexpr const size_t BasicFixedSizeStorage<Size,MaxSize,BlockMemory>::BLOCK_SIZE;
+template<size_t Size, size_t MaxSize, typename BlockMemory> constexpr const size_t BasicFixedSizeStorage<Size,MaxSize,BlockMemory>::OBJECT_ALIGNMENT;
+template<size_t Size, size_t MaxSize, typename BlockMemory> constexpr const size_t BasicFixedSizeStorage<Size,MaxSize,BlockMemory>::BLOCK_ALIGNMENT;
+template<size_t Size, size_t MaxSize, typename BlockMemory> constexpr const size_t BasicFixedSizeStorage<Size,MaxSize,BlockMemory>::RELEASE_OBJECTS;
+
+template<size_t Size, size_t MaxSize>
+using FixedSizeStorage = BasicFixedSizeStorage<Size, MaxSize, HeapBlocks>;
+
+// One object per cache line, neighbours owned by different threads never share a line
+template<size_t Size, size_t MaxSize>
+using PaddedFixedSizeStorage = BasicFixedSizeStorage<round_up(Size, CACHE_LINE_SIZE), MaxSize, HeapBlocks>;
+
+template<size_t Size, size_t BlockSize, typename BlockMemory>
+class BasicBlockListStorage {
 public:
     
     constexpr static const size_t OBJECT_SIZE = ((Size + sizeof(void *)-1) / sizeof(void *)) * sizeof(void *);
-    constexpr static const size_t OBJECTS_PER_BLOCK = BlockSize/OBJECT_SIZE;
+    // rounded down to a power of two so an index splits into block and slot with a shift and a mask
+    constexpr static const size_t OBJECTS_PER_BLOCK = floor_power_of_two(BlockSize/OBJECT_SIZE);
+    constexpr static const size_t BLOCK_SHIFT = log2_floor(OBJECTS_PER_BLOCK);
+    constexpr static const size_t BLOCK_MASK = OBJECTS_PER_BLOCK - 1;
     constexpr static const size_t BLOCK_SIZE = OBJECTS_PER_BLOCK * OBJECT_SIZE;
+    constexpr static const size_t OBJECT_ALIGNMENT = slot_alignment(OBJECT_SIZE);
+    constexpr static const size_t RELEASE_OBJECTS = OBJECTS_PER_BLOCK;
     
-    BlockListStorage() : mBlocks(1) {}
-    ~BlockListStorage(){ mBlocks.clear(); }
+    BasicBlockListStorage() { mBlocks.emplace_back(new Block); }
     
     void* operator[](size_t index) {
-        size_t block = floor(index / OBJECTS_PER_BLOCK);
-        if(block == mBlocks.size()){
-            mBlocks.emplace_back();
-        }else if(block > mBlocks.size()){
-            for(int i = 0; i < (block - mBlocks.size()); i++ ){
-                mBlocks.emplace_back();
-            }
+        size_t block = index >> BLOCK_SHIFT;
+        while(block >= mBlocks.size()){
+            mBlocks.emplace_back(new Block);
         }
-        auto it = mBlocks.begin();
-        std::advance(it, block);
-        return (*it)[index % OBJECTS_PER_BLOCK];
+        return (*mBlocks[block])[index & BLOCK_MASK];
     }
     
-    size_t capacity(){ return mBlocks.size() * OBJECTS_PER_BLOCK; }
-    size_t max_size(){ return mBlocks.size() * BLOCK_SIZE; }
+    // slots from index to the end of its block, which sit back to back in memory
+    size_t contiguous(size_t index){ return OBJECTS_PER_BLOCK - (index & BLOCK_MASK); }
+    
+    size_t capacity(){ return blocks() * OBJECTS_PER_BLOCK; }
+    size_t max_size(){ return blocks() * BLOCK_SIZE; }
+    // blocks currently holding memory, trimmed ones are backed again on their next use
+    size_t blocks(){
+        size_t count = 0;
+        for(auto& block : mBlocks){ count += block->blocks(); }
+        return count;
+    }
+    
+    // each block is a unit of trimming, its directory entry stays so indices never shift
+    size_t release_units(){ return mBlocks.size(); }
+    void* release_base(size_t unit){ return mBlocks[unit]->release_base(0); }
+    void release(size_t unit){ mBlocks[unit]->release(0); }
     
 private:
-    std::list<FixedSizeStorage<Size,BlockSize>> mBlocks;
+    typedef BasicFixedSizeStorage<Size,BLOCK_SIZE,BlockMemory> Block;
+    // directory of block pointers, growing it never moves the blocks themselves
+    std::vector<std::unique_ptr<Block>> mBlocks;
 };
 
-template <size_t Size, typename StorageType>
-class FreeStore : public IAllocator{
+template<size_t Size, size_t BlockSize, typename BlockMemory> constexpr const size_t BasicBlockListStorage<Size,BlockSize,BlockMemory>::OBJECT_SIZE;
+template<size_t Size, size_t BlockSize, typename BlockMemory> constexpr const size_t BasicBlockListStorage<Size,BlockSize,BlockMemory>::OBJECTS_PER_BLOCK;
+template<size_t Size, size_t BlockSize, typename BlockMemory> constexpr const size_t BasicBlockListStorage<Size,BlockSize,BlockMemory>::BLOCK_SHIFT;
+template<size_t Size, size_t BlockSize, typename BlockMemory> constexpr const size_t BasicBlockListStorage<Size,BlockSize,BlockMemory>::BLOCK_MASK;
+template<size_t Size, size_t BlockSize, typename BlockMemory> constexpr const size_t BasicBlockListStorage<Size,BlockSize,BlockMemory>::BLOCK_SIZE;
+template<size_t Size, size_t BlockSize, typename BlockMemory> constexpr const size_t BasicBlockListStorage<Size,BlockSize,BlockMemory>::OBJECT_ALIGNMENT;
+template<size_t Size, size_t BlockSize, typename BlockMemory> constexpr const size_t BasicBlockListStorage<Size,BlockSize,BlockMemory>::RELEASE_OBJECTS;
+
+template<size_t Size, size_t BlockSize>
+using BlockListStorage = BasicBlockListStorage<Size, BlockSize, HeapBlocks>;
+
+template<size_t Size, size_t BlockSize>
+using PaddedBlockListStorage = BasicBlockListStorage<round_up(Size, CACHE_LINE_SIZE), BlockSize, HeapBlocks>;
+
+// StatisticsPolicy is NoStatistics or AllocationStatistics, see AllocationStatistics.hpp. It is
+// a private base so the empty NoStatistics takes no space.
+template <size_t Size, typename StorageType, typename StatisticsPolicy = DefaultStatistics>
+class FreeStore : public IAllocator, private StatisticsPolicy{
 public:
     
+    // instances own their blocks and return them all when destroyed, get() is the shared one
+    constexpr static const bool POOLABLE = true;
+
+    FreeStore() = default;
+    
     static FreeStore* get(){
         if(!sFreeStore){
             sFreeStore.reset(new FreeStore);
@@ -90,33 +183,222 @@ public:
     }
     
     void* allocate(size_t count = 1)override {
+        ALLOCATOR_LATENCY_SAMPLE(allocateLatency());
         void* ret;
+        if(!mFreeStore && !mReleased.empty()){
+            restore();
+        }
         if(mFreeStore){
             ret = mFreeStore;
             auto next = *reinterpret_cast<void**>(mFreeStore);
             mFreeStore = next;
         }else{
-            ret = mStorage[mLast++];
+            ret = mStorage[mLast];
+            if(++mLast > mPeak) mPeak = mLast;
         }
-        std::cout << "allocating size of: " << Size << std::endl;
+        StatisticsPolicy::onAllocate();
         return ret;
     }
     
     void deallocate(void* ptr)override{
+        ALLOCATOR_LATENCY_SAMPLE(deallocateLatency());
         *reinterpret_cast<void**>(ptr) = mFreeStore;
         mFreeStore = ptr;
+        StatisticsPolicy::onDeallocate();
+        if(mAutoTrim && ++mSinceTrim >= mAutoTrim){
+            trim();
+        }
+    }
+    
+    // Unlink a run from the free list, then carve the remainder from the storage a block at a time
+    void allocate_n(void** ptrs, size_t count)override{
+        size_t taken = 0;
+        while(taken < count){
+            if(!mFreeStore && !mReleased.empty()){
+                restore();
+            }
+            if(!mFreeStore) break;
+            ptrs[taken++] = mFreeStore;
+            mFreeStore = *reinterpret_cast<void**>(mFreeStore);
+        }
+        while(taken < count){
+            size_t run = std::min(count - taken, mStorage.contiguous(mLast));
+            if(run == 0){
+                // nothing was counted yet, so put the slots back without touching the statistics
+                splice(ptrs, taken);
+                throw std::bad_alloc();
+            }
+            // touch the end of the run first so the whole run is backed
+            mStorage[mLast + run - 1];
+            auto slot = static_cast<char*>(mStorage[mLast]);
+            for(size_t i = 0; i < run; i++, slot += StorageType::OBJECT_SIZE){
+                ptrs[taken++] = slot;
+            }
+            mLast += run;
+        }
+        if(mLast > mPeak) mPeak = mLast;
+        StatisticsPolicy::onAllocate(count);
+    }
+    
+    // Link the slots together and splice them onto the free list in one step
+    void deallocate_n(void* const* ptrs, size_t count)override{
+        if(count == 0) return;
+        splice(ptrs, count);
+        StatisticsPolicy::onDeallocate(count);
+        if(mAutoTrim && (mSinceTrim += count) >= mAutoTrim){
+            trim();
+        }
+    }
+    
+    // Give blocks with no live objects back to the storage and return how many went. Occupancy
+    // is counted here from the free list rather than on every call, so allocate and deallocate
+    // stay as they were. Released slots are unlinked in a single pass over the free list.
+    size_t trim(){
+        mSinceTrim = 0;
+        const size_t unitSlots = StorageType::RELEASE_OBJECTS;
+        const size_t units = mStorage.release_units();
+        
+        // block bases sorted by address so a free slot maps back to its block
+        std::vector<std::pair<char*, size_t>> bases;
+        for(size_t unit = 0; unit < units; unit++){
+            if(auto base = mStorage.release_base(unit)){
+                bases.emplace_back(static_cast<char*>(base), unit);
+            }
+        }
+        std::sort(bases.begin(), bases.end());
+        auto unitOf = [&bases](void* ptr){
+            auto found = std::upper_bound(bases.begin(), bases.end(), std::make_pair(static_cast<char*>(ptr), SIZE_MAX));
+            return std::prev(found)->second;
+        };
+        
+        std::vector<size_t> freeSlots(units, 0);
+        for(auto slot = mFreeStore; slot; slot = *reinterpret_cast<void**>(slot)){
+            freeSlots[unitOf(slot)]++;
+        }
+        
+        // a block is empty once every slot carved from it is back on the free list, blocks
+        // nothing was carved from yet are left alone
+        std::vector<char> empty(units, 0);
+        size_t released = 0;
+        for(auto& base : bases){
+            size_t first = base.second * unitSlots;
+            size_t carved = first < mLast ? std::min(unitSlots, mLast - first) : 0;
+            if(carved && freeSlots[base.second] == carved){
+                empty[base.second] = 1;
+                ++released;
+            }
+        }
+        if(released == 0) return 0;
+        
+        void** tail = &mFreeStore;
+        for(auto slot = mFreeStore; slot; slot = *reinterpret_cast<void**>(slot)){
+            if(!empty[unitOf(slot)]){
+                *tail = slot;
+                tail = reinterpret_cast<void**>(slot);
+            }
+        }
+        *tail = nullptr;
+        
+        for(size_t unit = 0; unit < units; unit++){
+            if(empty[unit]){
+                mStorage.release(unit);
+                mReleased.push_back(unit);
+            }
+        }
+        
+        // released blocks at the top just lower the carve index, the rest wait to be reused
+        std::sort(mReleased.begin(), mReleased.end());
+        while(!mReleased.empty() && mLast && mReleased.back() == (mLast - 1) / unitSlots){
+            mLast = mReleased.back() * unitSlots;
+            mReleased.pop_back();
+        }
+        return released;
+    }
+    
+    // trim automatically after this many deallocations, 0 turns it off
+    void setAutoTrim(size_t deallocations){
+        mAutoTrim = deallocations;
+        mSinceTrim = 0;
     }
     
     size_t capacity() override { return mStorage.capacity(); }
     size_t max_size(){ return mStorage.max_size(); }
+    // the next allocate comes off the free list without touching the storage
+    bool has_free() const { return mFreeStore != nullptr; }
+    
+    // Counters are only filled in when the statistics policy is enabled. Fresh slots are only
+    // carved once the free list is empty, so the highest carve index reached is the exact
+    // high-water mark. trim() can lower the carve index, never the peak.
+    AllocationSnapshot statistics(){
+        AllocationSnapshot snapshot;
+        snapshot.high_water_mark = mPeak;
+        snapshot.blocks_reserved = mStorage.blocks();
+        if(StatisticsPolicy::ENABLED){
+            snapshot.allocations = StatisticsPolicy::allocations();
+            snapshot.deallocations = StatisticsPolicy::deallocations();
+            snapshot.live = snapshot.allocations - snapshot.deallocations;
+            snapshot.free_list_length = mLast - snapshot.live - mReleased.size() * StorageType::RELEASE_OBJECTS;
+        }
+        return snapshot;
+    }
+
+#if defined(ALLOCATOR_LATENCY)
+    // sampled call latencies
+    static LatencyRecorder& allocateLatency(){
+        static LatencyRecorder sRecorder(name() + "::allocate");
+        return sRecorder;
+    }
+
+    static LatencyRecorder& deallocateLatency(){
+        static LatencyRecorder sRecorder(name() + "::deallocate");
+        return sRecorder;
+    }
+#endif
 
 private:
+    static std::string name(){
+        return "FreeStore<" + std::to_string(Size) + "," + std::to_string(StorageType::BLOCK_SIZE) + ">";
+    }
+
+    void splice(void* const* ptrs, size_t count){
+        if(count == 0) return;
+        for(size_t i = 0; i < count - 1; i++){
+            *reinterpret_cast<void**>(ptrs[i]) = ptrs[i + 1];
+        }
+        *reinterpret_cast<void**>(ptrs[count - 1]) = mFreeStore;
+        mFreeStore = ptrs[0];
+    }
+
+    // free list is empty, link a whole trimmed block back onto it
+    void restore(){
+        const size_t unitSlots = StorageType::RELEASE_OBJECTS;
+        auto unit = mReleased.back();
+        mReleased.pop_back();
+        auto first = static_cast<char*>(mStorage[unit * unitSlots]);
+        for(size_t i = std::min(unitSlots, mStorage.contiguous(unit * unitSlots)); i-- > 0;){
+            auto slot = first + i * StorageType::OBJECT_SIZE;
+            *reinterpret_cast<void**>(slot) = mFreeStore;
+            mFreeStore = slot;
+        }
+    }
+    
     void* mFreeStore{nullptr};
     size_t mLast{0};
+    size_t mPeak{0};
     StorageType mStorage;
-    FreeStore() = default;
+    std::vector<size_t> mReleased;
+    size_t mAutoTrim{0};
+    size_t mSinceTrim{0};
     static std::unique_ptr<FreeStore> sFreeStore;
 };
 
+template <size_t Size, typename StorageType, typename StatisticsPolicy>
+std::unique_ptr<FreeStore<Size,StorageType,StatisticsPolicy>> FreeStore<Size,StorageType,StatisticsPolicy>::sFreeStore = nullptr;
+
+// FreeStore with the build's default statistics, usable where a two parameter store is expected
+template <size_t Size, typename StorageType>
+using DefaultFreeStore = FreeStore<Size, StorageType>;
+
+// FreeStore that always collects statistics, e.g. FreeStoreAllocator<T, BlockListStorage, N, CountedFreeStore>
 template <size_t Size, typename StorageType>
-std::unique_ptr<FreeStore<Size,StorageType>> FreeStore<Size,StorageType>::sFreeStore = nullptr;
+using CountedFreeStore = FreeStore<Size, StorageType, AllocationStatistics>;
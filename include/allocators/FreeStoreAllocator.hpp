@@ -12,36 +12,65 @@
 #include <exception>
 #include <list>
 #include <iostream>
+#include "AllocatorTraits.hpp"
 #include "Heap.hpp"
 #include "FreeStore.hpp"
+#include "FreeStorePool.hpp"
 
-template<typename T, template<size_t,size_t> class StorageType, size_t StorageSize>
+// Store selects the free store front end, e.g. DefaultFreeStore, CountedFreeStore or MagazineFreeStore.
+// Alignment raises the slot alignment above alignof(T), 0 keeps alignof(T). Slots are padded to a
+// multiple of it and the storages align every slot to the padded size.
+// A default constructed allocator uses the store_type singleton, one constructed from a
+// FreeStorePool uses that pool's store and so do all allocators rebound or copied from it.
+// Only per instance stores (is_poolable_store, e.g. DefaultFreeStore, CountedFreeStore or
+// NumaFreeStore) can come from a pool, the thread caching stores are singletons only.
+template<typename T, template<size_t,size_t> class StorageType, size_t StorageSize,
+    template<size_t,typename> class Store = DefaultFreeStore, size_t Alignment = 0>
 class FreeStoreAllocator
 {
 public:
     
     ALLOCATOR_TRAITS(T)
+    STATEFUL_ALLOCATOR_TRAITS
+    
+    constexpr static const size_t ALIGNMENT = Alignment > alignof(T) ? Alignment : alignof(T);
+    constexpr static const size_t SLOT_SIZE = round_up(sizeof(T), ALIGNMENT);
+    
+    static_assert((ALIGNMENT & (ALIGNMENT - 1)) == 0, "Alignment must be a power of two");
+    static_assert(ALIGNMENT <= 4096, "storages align slots to at most a page");
+    
+    typedef StorageType<SLOT_SIZE,StorageSize> storage_type;
+    typedef Store<SLOT_SIZE,storage_type> store_type;
     
     template<typename U>
     struct rebind
     {
-        typedef FreeStoreAllocator<U,StorageType,StorageSize> other;
+        typedef FreeStoreAllocator<U,StorageType,StorageSize,Store,Alignment> other;
     };
     
     // Default Constructor
     FreeStoreAllocator() = default;
     
+    // Allocate from the pool's stores, Store must be poolable
+    explicit FreeStoreAllocator(FreeStorePool& pool) :
+    mPool(&pool),
+    mStore(pool.store<store_type>())
+    {}
+    
     // Copy Constructor
-    template<typename U>
-    FreeStoreAllocator(FreeStoreAllocator<U,StorageType,StorageSize> const& other){}
+    template<typename U, size_t AlignmentU>
+    FreeStoreAllocator(FreeStoreAllocator<U,StorageType,StorageSize,Store,AlignmentU> const& other) :
+    mPool(other.pool()),
+    mStore(store_for(mPool, is_poolable_store<store_type>()))
+    {}
     
     // Allocate memory from freestore
     pointer allocate(size_type count = 1, const_pointer hint = 0)
     {
         if(count == 1){
-            return static_cast<pointer>(FreeStore<sizeof(T),StorageType<sizeof(T),StorageSize>>::get()->allocate());
+            return static_cast<pointer>(mStore->allocate());
         }else{
-            return static_cast<pointer>(Heap<sizeof(T)>::get()->allocate(count));
+            return static_cast<pointer>(Heap<sizeof(T),ALIGNMENT>::get()->allocate(count));
         }
     }
     
@@ -49,16 +78,62 @@ public:
     void deallocate(pointer ptr, size_type count = 1)
     {
         if(count == 1){
-             FreeStore<sizeof(T),StorageType<sizeof(T),StorageSize>>::get()->deallocate(ptr);
+             mStore->deallocate(ptr);
         }else{
-            Heap<sizeof(T)>::get()->deallocate(ptr);
+            Heap<sizeof(T),ALIGNMENT>::get()->deallocate(ptr);
         }
     }
     
+    // Fill ptrs with count single objects from the freestore in one call
+    void allocate_n(pointer* ptrs, size_type count)
+    {
+        mStore->allocate_n(reinterpret_cast<void**>(ptrs), count);
+    }
+    
+    // place count single objects back on the freestore in one call
+    void deallocate_n(pointer const* ptrs, size_type count)
+    {
+        mStore->deallocate_n(reinterpret_cast<void* const*>(ptrs), count);
+    }
+    
     // Max number of objects that can be allocated in one call
-    size_type max_size(void) const {return StorageType<sizeof(T),StorageSize>::BLOCK_SIZE;}
-    size_t capacity(){ return FreeStore<sizeof(T),StorageType<sizeof(T),StorageSize>>::get()->capacity(); }
+    size_type max_size(void) const {return storage_type::BLOCK_SIZE;}
+    size_t capacity(){ return mStore->capacity(); }
+    AllocationSnapshot statistics(){ return mStore->statistics(); }
     
+    // the pool allocations come from, nullptr for the singleton stores
+    FreeStorePool* pool() const { return mPool; }
+    store_type* store() const { return mStore; }
+    
+private:
+    static store_type* store_for(FreeStorePool* pool, std::true_type){
+        return pool ? pool->template store<store_type>() : store_type::get();
+    }
+    // never constructed from a pool, so the singleton
+    static store_type* store_for(FreeStorePool*, std::false_type){ return store_type::get(); }
+
+    FreeStorePool* mPool{nullptr};
+    store_type* mStore{store_type::get()};
 };
 
+// Equal when drawing from the same pool, so memory from one can be freed through the other
+template<typename T, typename U, template<size_t,size_t> class StorageType, size_t StorageSize,
+    template<size_t,typename> class Store, size_t Alignment, size_t AlignmentU>
+bool operator==(FreeStoreAllocator<T,StorageType,StorageSize,Store,Alignment> const& left,
+                FreeStoreAllocator<U,StorageType,StorageSize,Store,AlignmentU> const& right)
+{
+    return left.pool() == right.pool();
+}
+
+template<typename T, typename U, template<size_t,size_t> class StorageType, size_t StorageSize,
+    template<size_t,typename> class Store, size_t Alignment, size_t AlignmentU>
+bool operator!=(FreeStoreAllocator<T,StorageType,StorageSize,Store,Alignment> const& left,
+                FreeStoreAllocator<U,StorageType,StorageSize,Store,AlignmentU> const& right)
+{
+    return !(left == right);
+}
 
+template<typename T, template<size_t,size_t> class StorageType, size_t StorageSize, template<size_t,typename> class Store, size_t Alignment>
+constexpr const size_t FreeStoreAllocator<T,StorageType,StorageSize,Store,Alignment>::ALIGNMENT;
+template<typename T, template<size_t,size_t> class StorageType, size_t StorageSize, template<size_t,typename> class Store, size_t Alignment>
+constexpr const size_t FreeStoreAllocator<T,StorageType,StorageSize,Store,Alignment>::SLOT_SIZE;
@@ -0,0 +1,64 @@
+//
+//  FreeStorePool.hpp
+//  MemoryManagement
+//
+
+#pragma once
+
+#include <memory>
+#include <type_traits>
+#include <typeindex>
+#include <utility>
+#include <vector>
+#include "IAllocator.h"
+
+// Stores whose instances share no state opt in with POOLABLE. Thread caching stores keep their
+// caches in per type statics and hide their constructors, so they only exist as singletons.
+template<typename Store, typename = void>
+struct is_poolable_store : std::false_type {};
+
+template<typename Store>
+struct is_poolable_store<Store, typename std::enable_if<Store::POOLABLE>::type> : std::true_type {};
+
+// A set of free stores owned by one subsystem, e.g. a connection, instead of the process wide
+// singletons. Each store type is created the first time an allocator asks for it, so rebinding
+// a container's allocator to its node type lands in the same pool. Destroying or clearing the
+// pool hands every block back at once, whether or not the objects in it were deallocated.
+class FreeStorePool {
+public:
+
+    FreeStorePool() = default;
+
+    FreeStorePool(const FreeStorePool&) = delete;
+    FreeStorePool& operator=(const FreeStorePool&) = delete;
+
+    // the pool's instance of Store, created on first use
+    template<typename Store>
+    Store* store(){
+        static_assert(is_poolable_store<Store>::value,
+            "FreeStorePool only holds per instance stores such as FreeStore and NumaFreeStore, "
+            "thread caching stores like MagazineFreeStore are process wide singletons");
+        std::type_index type(typeid(Store));
+        for(auto& entry : mStores){
+            if(entry.first == type) return static_cast<Store*>(entry.second.get());
+        }
+        auto store = new Store;
+        mStores.emplace_back(type, std::unique_ptr<IAllocator>(store));
+        return store;
+    }
+
+    size_t stores() const { return mStores.size(); }
+
+    // objects in total across every store in the pool
+    size_t capacity(){
+        size_t total = 0;
+        for(auto& entry : mStores){ total += entry.second->capacity(); }
+        return total;
+    }
+
+    // drop every store, anything still allocated from the pool is gone
+    void clear(){ mStores.clear(); }
+
+private:
+    std::vector<std::pair<std::type_index, std::unique_ptr<IAllocator>>> mStores;
+};
@@ -9,12 +9,16 @@
 
 #include <stdint.h>
 #include <memory>
+#include <new>
 #include "IAllocator.h"
 
-template <size_t Size>
+// Alignment beyond DEFAULT_ALIGNMENT goes through aligned_allocate
+template <size_t Size, size_t Alignment = DEFAULT_ALIGNMENT>
 class Heap : public IAllocator {
 public:
     
+    Heap() = default;
+    
     static Heap* get(){
         if(!sHeap){
             sHeap.reset(new Heap);
@@ -23,20 +27,26 @@ public:
     }
     
     void* allocate(size_t count)override {
+        if(Alignment > DEFAULT_ALIGNMENT){
+            return aligned_allocate(round_up(count * Size, Alignment), Alignment);
+        }
         return ::operator new(count * Size, ::std::nothrow);
     }
     
     void deallocate(void* ptr)override{
-        ::operator delete(ptr);
+        if(Alignment > DEFAULT_ALIGNMENT){
+            aligned_deallocate(ptr);
+        }else{
+            ::operator delete(ptr);
+        }
     }
     
     size_t capacity() override { return max_allocations<Size>::value; }
     
 private:
-    Heap() = default;
     static std::unique_ptr<Heap> sHeap;
 };
 
-template <size_t Size>
-std::unique_ptr<Heap<Size>> Heap<Size>::sHeap = nullptr;
+template <size_t Size, size_t Alignment>
+std::unique_ptr<Heap<Size,Alignment>> Heap<Size,Alignment>::sHeap = nullptr;
 
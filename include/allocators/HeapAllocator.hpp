@@ -9,42 +9,77 @@
 #pragma once
 #include "AllocatorTraits.hpp"
 #include "IAllocator.h"
+#include "LatencySample.hpp"
 
-template<typename T>
+// Alignment raises the alignment above alignof(T), e.g. to a cache line, 0 keeps alignof(T)
+template<typename T, size_t Alignment = 0>
 class HeapAllocator
 {
 public:
 	
 	ALLOCATOR_TRAITS(T)
+	STATELESS_ALLOCATOR_TRAITS
 	
+	constexpr static const size_t ALIGNMENT = Alignment > alignof(T) ? Alignment : alignof(T);
+	
+	static_assert((ALIGNMENT & (ALIGNMENT - 1)) == 0, "Alignment must be a power of two");
+	
+	// a raised alignment carries over to rebound types
 	template<typename U>
 	struct rebind
 	{
-		typedef HeapAllocator<U> other;
+		typedef HeapAllocator<U, Alignment> other;
 	};
 	
 	// Default Constructor
 	HeapAllocator(void) = default;
 	
 	// Copy Constructor
-	template<typename U>
-	HeapAllocator(HeapAllocator<U> const& other){}
+	template<typename U, size_t AlignmentU>
+	HeapAllocator(HeapAllocator<U,AlignmentU> const& other){}
 	
 	// Allocate memory
 	pointer allocate(size_type count, const_pointer hint = 0)
 	{
+		ALLOCATOR_LATENCY_SAMPLE(latency());
 		if(count > max_size()){throw std::bad_alloc();}
+		if(ALIGNMENT > DEFAULT_ALIGNMENT){
+			return static_cast<pointer>(aligned_allocate(round_up(count * sizeof(type), ALIGNMENT), ALIGNMENT));
+		}
 		return static_cast<pointer>(::operator new(count * sizeof(type), ::std::nothrow));
 	}
 	
 	// Delete memory
 	void deallocate(pointer ptr, size_type count)
 	{
-		::operator delete(ptr);
+		if(ALIGNMENT > DEFAULT_ALIGNMENT){
+			aligned_deallocate(ptr);
+		}else{
+			::operator delete(ptr);
+		}
 	}
 	
 	// Max number of objects that can be allocated in one call
 	size_type max_size(void) const {return max_allocations<sizeof(T)>::value;}
     
     size_t capacity(){ return max_size(); }
+	
+#if defined(ALLOCATOR_LATENCY)
+	// Sampled allocate latency
+	static LatencyRecorder& latency()
+	{
+		static LatencyRecorder sRecorder("HeapAllocator<" + std::to_string(sizeof(T)) + ">::allocate");
+		return sRecorder;
+	}
+#endif
 };
+
+template<typename T, size_t Alignment>
+constexpr const size_t HeapAllocator<T,Alignment>::ALIGNMENT;
+
+// Equal when both free through the same path, raised alignments use aligned_deallocate
+template<typename T, size_t Alignment, typename U, size_t AlignmentU>
+bool operator==(HeapAllocator<T,Alignment> const& left, HeapAllocator<U,AlignmentU> const& right)
+{
+	return (HeapAllocator<T,Alignment>::ALIGNMENT > DEFAULT_ALIGNMENT) == (HeapAllocator<U,AlignmentU>::ALIGNMENT > DEFAULT_ALIGNMENT);
+}
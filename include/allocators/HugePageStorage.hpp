@@ -0,0 +1,14 @@
+//
+//  HugePageStorage.hpp
+//  MemoryManagement
+//
+
+#pragma once
+
+#include "FreeStore.hpp"
+#include "HugePages.hpp"
+
+// Block list storage whose blocks are mapped on 2 MiB pages. Pick a BlockSize close to a
+// multiple of HUGE_PAGE_SIZE so little of each mapped page goes unused.
+template<size_t Size, size_t BlockSize>
+using HugePageStorage = BasicBlockListStorage<Size, BlockSize, HugePageBlocks>;
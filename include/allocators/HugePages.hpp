@@ -0,0 +1,105 @@
+//
+//  HugePages.hpp
+//  MemoryManagement
+//
+
+#pragma once
+
+#include <atomic>
+#include <new>
+#include "VirtualMemory.hpp"
+
+enum class HugePageMode {
+    None,           // regular pages, nothing better was available
+    Transparent,    // aligned mapping advised with MADV_HUGEPAGE
+    Explicit        // MAP_HUGETLB from the reserved hugetlbfs pool
+};
+
+// Counts of blocks mapped through each path, so deployments can confirm huge pages are in use
+struct HugePageReport {
+    size_t explicitBlocks{0};
+    size_t transparentBlocks{0};
+    size_t regularBlocks{0};
+};
+
+// Block memory backed by 2 MiB pages. Tries the hugetlbfs pool first, then falls back to a
+// 2 MiB aligned anonymous mapping advised for transparent huge pages.
+struct HugePageBlocks {
+
+    constexpr static const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+    static void* allocate(size_t bytes, size_t alignment){
+        HugePageMode mode;
+        auto block = map(roundToHugePages(bytes), mode);
+        if(!block) throw std::bad_alloc();
+        counter(mode)++;
+        lastMode() = mode;
+        return block;
+    }
+
+    static void deallocate(void* block, size_t bytes, size_t alignment){
+        VirtualMemory::release(block, roundToHugePages(bytes));
+    }
+
+    // mode of the most recently mapped block
+    static HugePageMode mode(){ return lastMode(); }
+
+    static HugePageReport report(){
+        HugePageReport report;
+        report.explicitBlocks = counter(HugePageMode::Explicit);
+        report.transparentBlocks = counter(HugePageMode::Transparent);
+        report.regularBlocks = counter(HugePageMode::None);
+        return report;
+    }
+
+    static size_t roundToHugePages(size_t bytes){
+        return ((bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE) * HUGE_PAGE_SIZE;
+    }
+
+private:
+
+    static void* map(size_t bytes, HugePageMode& mode){
+#if defined(_WIN32)
+        mode = HugePageMode::None;
+        return VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+#if defined(MAP_HUGETLB)
+        auto huge = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if(huge != MAP_FAILED){
+            mode = HugePageMode::Explicit;
+            return huge;
+        }
+#endif
+        // over map by a huge page so the block can be trimmed to a 2 MiB boundary
+        auto raw = mmap(nullptr, bytes + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(raw == MAP_FAILED) return nullptr;
+        auto start = reinterpret_cast<uintptr_t>(raw);
+        auto aligned = (start + HUGE_PAGE_SIZE - 1) & ~(uintptr_t(HUGE_PAGE_SIZE) - 1);
+        if(aligned > start){
+            munmap(raw, aligned - start);
+        }
+        auto tail = (start + bytes + HUGE_PAGE_SIZE) - (aligned + bytes);
+        if(tail){
+            munmap(reinterpret_cast<void*>(aligned + bytes), tail);
+        }
+        auto block = reinterpret_cast<void*>(aligned);
+        mode = HugePageMode::None;
+#if defined(MADV_HUGEPAGE)
+        if(madvise(block, bytes, MADV_HUGEPAGE) == 0){
+            mode = HugePageMode::Transparent;
+        }
+#endif
+        return block;
+#endif
+    }
+
+    static std::atomic<size_t>& counter(HugePageMode mode){
+        static std::atomic<size_t> sCounters[3];
+        return sCounters[static_cast<int>(mode)];
+    }
+
+    static std::atomic<HugePageMode>& lastMode(){
+        static std::atomic<HugePageMode> sMode{HugePageMode::None};
+        return sMode;
+    }
+};
@@ -7,7 +7,12 @@
 
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
+#include <stdlib.h>
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
 
 template<size_t Size>
 struct max_allocations
@@ -15,9 +20,87 @@ struct max_allocations
     enum{value = static_cast<std::size_t>(-1) / Size};
 };
 
+// Largest power of two not greater than value (1 for 0)
+constexpr size_t floor_power_of_two(size_t value, size_t power = 1)
+{
+    return (power << 1) != 0 && (power << 1) <= value ? floor_power_of_two(value, power << 1) : power;
+}
+
+constexpr size_t log2_floor(size_t value)
+{
+    return value <= 1 ? 0 : 1 + log2_floor(value >> 1);
+}
+
+// Largest power of two dividing value
+constexpr size_t lowest_set_bit(size_t value)
+{
+    return value & (~value + 1);
+}
+
+constexpr size_t round_up(size_t value, size_t multiple)
+{
+    return ((value + multiple - 1) / multiple) * multiple;
+}
+
+// Storages align slots to the largest power of two dividing their size, up to a page, so a
+// size rounded up to a type's alignment keeps every slot aligned for it
+constexpr size_t slot_alignment(size_t objectSize)
+{
+    return lowest_set_bit(objectSize) < 4096 ? lowest_set_bit(objectSize) : 4096;
+}
+
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+// Largest alignment plain operator new guarantees
+constexpr size_t DEFAULT_ALIGNMENT = alignof(max_align_t);
+
+// Memory aligned beyond DEFAULT_ALIGNMENT, nullptr on failure, release with aligned_deallocate
+inline void* aligned_allocate(size_t bytes, size_t alignment)
+{
+#if defined(_WIN32)
+    return _aligned_malloc(bytes, alignment);
+#else
+    void* ptr = nullptr;
+    if(alignment < sizeof(void*)) alignment = sizeof(void*);
+    return posix_memalign(&ptr, alignment, bytes) == 0 ? ptr : nullptr;
+#endif
+}
+
+inline void aligned_deallocate(void* ptr)
+{
+#if defined(_WIN32)
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
 class IAllocator {
 public:
+    // stores can be owned through an IAllocator, e.g. by a FreeStorePool
+    virtual ~IAllocator() = default;
+    
     virtual void * allocate(size_t) = 0;
     virtual void deallocate(void*) = 0;
     virtual size_t capacity()  = 0;
+    
+    // Fill ptrs with count single allocations, all or nothing
+    virtual void allocate_n(void** ptrs, size_t count){
+        size_t i = 0;
+        try{
+            for(; i < count; i++){
+                ptrs[i] = allocate(1);
+            }
+        }catch(...){
+            deallocate_n(ptrs, i);
+            throw;
+        }
+    }
+    
+    // Return count single allocations
+    virtual void deallocate_n(void* const* ptrs, size_t count){
+        for(size_t i = 0; i < count; i++){
+            deallocate(ptrs[i]);
+        }
+    }
 };
@@ -0,0 +1,292 @@
+//
+//  LatencyRecorder.hpp
+//  MemoryManagement
+//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "BitOps.hpp"
+
+#if defined(_WIN32)
+#include <chrono>
+#else
+#include <time.h>
+#endif
+
+// Log linear histogram in the style of HdrHistogram. Values below SUB_BUCKETS get their own
+// bucket, above that each power of two is split into SUB_BUCKETS linear buckets, so any
+// recorded value is known to within 1/SUB_BUCKETS of itself. Only one thread records into a
+// histogram at a time, readers may merge it concurrently.
+class LatencyHistogram {
+public:
+
+    constexpr static const unsigned SUB_BUCKET_BITS = 4;
+    constexpr static const uint64_t SUB_BUCKETS = uint64_t(1) << SUB_BUCKET_BITS;
+    constexpr static const size_t BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    LatencyHistogram(){ reset(); }
+    LatencyHistogram(const LatencyHistogram& other){ reset(); merge(other); }
+    LatencyHistogram& operator=(const LatencyHistogram& other){ reset(); merge(other); return *this; }
+
+    static size_t bucket(uint64_t value){
+        if(value < SUB_BUCKETS) return static_cast<size_t>(value);
+        auto shift = find_last_set(value) - SUB_BUCKET_BITS;
+        return static_cast<size_t>((shift + 1) * SUB_BUCKETS + ((value >> shift) - SUB_BUCKETS));
+    }
+
+    // smallest value that lands in bucket
+    static uint64_t lowest(size_t bucket){
+        if(bucket < SUB_BUCKETS) return bucket;
+        return (SUB_BUCKETS + bucket % SUB_BUCKETS) << (bucket / SUB_BUCKETS - 1);
+    }
+
+    // largest value that lands in bucket
+    static uint64_t highest(size_t bucket){
+        return bucket + 1 < BUCKETS ? lowest(bucket + 1) - 1 : UINT64_MAX;
+    }
+
+    void record(uint64_t value){
+        add(mCounts[bucket(value)], 1);
+        add(mCount, 1);
+        add(mSum, value);
+        if(value < mMin.load(std::memory_order_relaxed)) mMin.store(value, std::memory_order_relaxed);
+        if(value > mMax.load(std::memory_order_relaxed)) mMax.store(value, std::memory_order_relaxed);
+    }
+
+    void merge(const LatencyHistogram& other){
+        for(size_t i = 0; i < BUCKETS; i++){
+            add(mCounts[i], other.mCounts[i].load(std::memory_order_relaxed));
+        }
+        add(mCount, other.mCount.load(std::memory_order_relaxed));
+        add(mSum, other.mSum.load(std::memory_order_relaxed));
+        mMin.store(std::min(min(), other.min()), std::memory_order_relaxed);
+        mMax.store(std::max(max(), other.max()), std::memory_order_relaxed);
+    }
+
+    void reset(){
+        for(auto& count : mCounts){ count.store(0, std::memory_order_relaxed); }
+        mCount.store(0, std::memory_order_relaxed);
+        mSum.store(0, std::memory_order_relaxed);
+        mMin.store(UINT64_MAX, std::memory_order_relaxed);
+        mMax.store(0, std::memory_order_relaxed);
+    }
+
+    uint64_t count() const { return mCount.load(std::memory_order_relaxed); }
+    uint64_t min() const { return mMin.load(std::memory_order_relaxed); }
+    uint64_t max() const { return mMax.load(std::memory_order_relaxed); }
+    double mean() const { return count() ? double(mSum.load(std::memory_order_relaxed)) / count() : 0.0; }
+    uint64_t count(size_t bucket) const { return mCounts[bucket].load(std::memory_order_relaxed); }
+
+    // upper bound of the bucket holding the given percentile, 0 to 100
+    uint64_t percentile(double percent) const {
+        auto total = count();
+        if(total == 0) return 0;
+        auto target = static_cast<uint64_t>(std::max(1.0, percent / 100.0 * total + 0.5));
+        uint64_t seen = 0;
+        for(size_t i = 0; i < BUCKETS; i++){
+            seen += count(i);
+            if(seen >= target) return std::min(highest(i), max());
+        }
+        return max();
+    }
+
+    // summary line followed by one "lowest highest count" line per non empty bucket
+    void dump(std::ostream& out) const {
+        out << "count=" << count() << " min=" << (count() ? min() : 0) << " mean=" << mean()
+            << " p50=" << percentile(50) << " p99=" << percentile(99) << " p99.9=" << percentile(99.9)
+            << " max=" << max() << "\n";
+        for(size_t i = 0; i < BUCKETS; i++){
+            if(count(i)) out << lowest(i) << " " << highest(i) << " " << count(i) << "\n";
+        }
+    }
+
+private:
+
+    static void add(std::atomic<uint64_t>& counter, uint64_t value){
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t> mCounts[BUCKETS];
+    std::atomic<uint64_t> mCount;
+    std::atomic<uint64_t> mSum;
+    std::atomic<uint64_t> mMin;
+    std::atomic<uint64_t> mMax;
+};
+
+// Named, sampled latency recorder. Each thread records into its own histogram, merged() folds
+// them together, and every live recorder can be written to one file with dumpAll().
+class LatencyRecorder {
+public:
+
+    explicit LatencyRecorder(std::string name, uint32_t samplePeriod = 64) :
+    mName(std::move(name)),
+    mId(nextId())
+    {
+        setSamplePeriod(samplePeriod);
+        std::lock_guard<std::mutex> lock(registryMutex());
+        registry().push_back(this);
+    }
+
+    ~LatencyRecorder(){
+        std::lock_guard<std::mutex> lock(registryMutex());
+        auto& recorders = registry();
+        recorders.erase(std::remove(recorders.begin(), recorders.end(), this), recorders.end());
+        destroyed().fetch_add(1, std::memory_order_release);
+    }
+
+    LatencyRecorder(const LatencyRecorder&) = delete;
+    LatencyRecorder& operator=(const LatencyRecorder&) = delete;
+
+    const std::string& name() const { return mName; }
+
+    // record roughly one call in period, rounded up to a power of two, 0 disables sampling
+    void setSamplePeriod(uint32_t period){
+        uint32_t mask = 0;
+        while(mask + 1 < period) mask = (mask << 1) | 1;
+        mSampleMask.store(period ? mask : UINT32_MAX, std::memory_order_relaxed);
+        mEnabled.store(period != 0, std::memory_order_relaxed);
+    }
+
+    // the tick is per recorder and thread, so recorders used in lockstep still sample each other
+    bool sample(){
+        return mEnabled.load(std::memory_order_relaxed) && ((++local().tick & mSampleMask.load(std::memory_order_relaxed)) == 0);
+    }
+
+    void record(uint64_t nanoseconds){ local().histogram->record(nanoseconds); }
+
+    LatencyHistogram merged() const {
+        LatencyHistogram histogram;
+        std::lock_guard<std::mutex> lock(mMutex);
+        for(auto& shard : mShards){ histogram.merge(*shard); }
+        return histogram;
+    }
+
+    void dump(std::ostream& out) const {
+        out << "# " << mName << "\n";
+        merged().dump(out);
+    }
+
+    bool dump(const std::string& path) const {
+        std::ofstream out(path);
+        dump(out);
+        return static_cast<bool>(out);
+    }
+
+    static bool dumpAll(const std::string& path){
+        std::ofstream out(path);
+        std::lock_guard<std::mutex> lock(registryMutex());
+        for(auto recorder : registry()){ recorder->dump(out); }
+        return static_cast<bool>(out);
+    }
+
+    static uint64_t now(){
+#if defined(_WIN32)
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#else
+        timespec time;
+        clock_gettime(CLOCK_MONOTONIC, &time);
+        return uint64_t(time.tv_sec) * 1000000000ull + uint64_t(time.tv_nsec);
+#endif
+    }
+
+    // Times its own scope when the recorder decides to sample this call
+    class Sample {
+    public:
+        explicit Sample(LatencyRecorder& recorder) :
+        mRecorder(recorder.sample() ? &recorder : nullptr),
+        mStart(mRecorder ? now() : 0)
+        {}
+        ~Sample(){
+            if(mRecorder) mRecorder->record(now() - mStart);
+        }
+        Sample(const Sample&) = delete;
+        Sample& operator=(const Sample&) = delete;
+    private:
+        LatencyRecorder* mRecorder;
+        uint64_t mStart;
+    };
+
+private:
+
+    // what one thread keeps for one recorder
+    struct Shard {
+        uint64_t id;
+        uint32_t tick;
+        LatencyHistogram* histogram;
+    };
+
+    // every shard a thread holds, with the last one used in front of the scan
+    struct ThreadShards {
+        std::vector<Shard> shards;
+        Shard* last{nullptr};
+        uint64_t destroyed{0};
+    };
+
+    // this thread's shard, looked up by recorder id so a recycled address never matches
+    Shard& local(){
+        static thread_local ThreadShards tLocal;
+        if(tLocal.last && tLocal.last->id == mId) return *tLocal.last;
+        for(auto& entry : tLocal.shards){
+            if(entry.id == mId) return *(tLocal.last = &entry);
+        }
+        prune(tLocal);
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mShards.emplace_back(new LatencyHistogram);
+            tLocal.shards.push_back(Shard{mId, 0, mShards.back().get()});
+        }
+        return *(tLocal.last = &tLocal.shards.back());
+    }
+
+    // drop this thread's shards of recorders destroyed since it last looked, their histograms
+    // went with them. Only runs when the thread meets a new recorder.
+    static void prune(ThreadShards& local){
+        auto count = destroyed().load(std::memory_order_acquire);
+        if(count == local.destroyed) return;
+        std::lock_guard<std::mutex> lock(registryMutex());
+        auto& recorders = registry();
+        local.shards.erase(std::remove_if(local.shards.begin(), local.shards.end(), [&recorders](const Shard& shard){
+            return std::none_of(recorders.begin(), recorders.end(), [&shard](LatencyRecorder* recorder){ return recorder->mId == shard.id; });
+        }), local.shards.end());
+        local.last = nullptr;
+        local.destroyed = count;
+    }
+
+    static std::atomic<uint64_t>& destroyed(){
+        static std::atomic<uint64_t> sDestroyed{0};
+        return sDestroyed;
+    }
+
+    static uint64_t nextId(){
+        static std::atomic<uint64_t> sNext{0};
+        return ++sNext;
+    }
+
+    static std::vector<LatencyRecorder*>& registry(){
+        static std::vector<LatencyRecorder*> sRecorders;
+        return sRecorders;
+    }
+
+    static std::mutex& registryMutex(){
+        static std::mutex sMutex;
+        return sMutex;
+    }
+
+    std::string mName;
+    uint64_t mId;
+    std::atomic<uint32_t> mSampleMask{0};
+    std::atomic<bool> mEnabled{true};
+    mutable std::mutex mMutex;
+    std::vector<std::unique_ptr<LatencyHistogram>> mShards;
+};
+
+#include "LatencySample.hpp"
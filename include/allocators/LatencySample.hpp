@@ -0,0 +1,15 @@
+//
+//  LatencySample.hpp
+//  MemoryManagement
+//
+
+#pragma once
+
+// Define ALLOCATOR_LATENCY to time a sample of calls at every instrumented site. Without it the
+// sites compile away and LatencyRecorder, with its streams and locks, is never pulled in.
+#if defined(ALLOCATOR_LATENCY)
+#include "LatencyRecorder.hpp"
+#define ALLOCATOR_LATENCY_SAMPLE(recorder) LatencyRecorder::Sample latencySample(recorder)
+#else
+#define ALLOCATOR_LATENCY_SAMPLE(recorder)
+#endif
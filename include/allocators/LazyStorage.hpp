@@ -0,0 +1,31 @@
+//
+//  LazyStorage.hpp
+//  MemoryManagement
+//
+
+#pragma once
+
+#include <new>
+#include "FreeStore.hpp"
+#include "VirtualMemory.hpp"
+
+// Block memory mapped straight from the system instead of zeroed up front. The whole block is
+// mapped read/write at once, which is constant time whatever its size; the kernel only backs a
+// page, already zeroed, the first time it is touched. Carving slots touches nothing by itself.
+// With transparent huge pages set to always, a touch may back a whole huge page.
+struct LazyBlocks {
+    static void* allocate(size_t bytes, size_t alignment){
+        auto block = VirtualMemory::map(VirtualMemory::roundToPages(bytes));
+        if(!block) throw std::bad_alloc();
+        return block;
+    }
+    static void deallocate(void* block, size_t bytes, size_t alignment){
+        VirtualMemory::release(block, VirtualMemory::roundToPages(bytes));
+    }
+};
+
+template<size_t Size, size_t MaxSize>
+using LazyFixedSizeStorage = BasicFixedSizeStorage<Size, MaxSize, LazyBlocks>;
+
+template<size_t Size, size_t BlockSize>
+using LazyBlockListStorage = BasicBlockListStorage<Size, BlockSize, LazyBlocks>;
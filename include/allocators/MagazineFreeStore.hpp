@@ -0,0 +1,153 @@
+//
+//  MagazineFreeStore.hpp
+//  MemoryManagement
+//
+
+#pragma once
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+#include <utility>
+#include "FreeStore.hpp"
+
+// Thread caching free store. Each thread keeps two magazines (fixed size stacks of free slots)
+// and only goes to the shared depot, under a lock, to trade a whole magazine at a time.
+template <size_t Size, typename StorageType>
+class MagazineFreeStore : public IAllocator{
+public:
+
+    constexpr static const size_t MAGAZINE_SIZE = 64;
+
+    static MagazineFreeStore* get(){
+        // function local static, so the first call is safe from any thread
+        static MagazineFreeStore sFreeStore;
+        return &sFreeStore;
+    }
+
+    ~MagazineFreeStore(){
+        for(auto magazine : mFull){ delete magazine; }
+        for(auto magazine : mEmpty){ delete magazine; }
+    }
+
+    void* allocate(size_t count = 1)override {
+        auto& cache = sCache;
+        if(cache.loaded->count == 0){
+            if(cache.previous->count == 0){
+                reload(cache);
+            }else{
+                std::swap(cache.loaded, cache.previous);
+            }
+        }
+        return cache.loaded->rounds[--cache.loaded->count];
+    }
+
+    void deallocate(void* ptr)override{
+        auto& cache = sCache;
+        if(cache.loaded->count == MAGAZINE_SIZE){
+            if(cache.previous->count == MAGAZINE_SIZE){
+                unload(cache);
+            }else{
+                std::swap(cache.loaded, cache.previous);
+            }
+        }
+        cache.loaded->rounds[cache.loaded->count++] = ptr;
+    }
+
+    size_t capacity() override {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mStorage.capacity();
+    }
+
+    size_t max_size(){
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mStorage.max_size();
+    }
+
+private:
+
+    struct Magazine {
+        size_t count{0};
+        void* rounds[MAGAZINE_SIZE];
+    };
+
+    struct ThreadCache {
+        ThreadCache(){
+            auto store = get();
+            std::lock_guard<std::mutex> lock(store->mMutex);
+            loaded = store->acquireEmpty();
+            previous = store->acquireEmpty();
+        }
+        // hand whatever this thread still holds back to the depot
+        ~ThreadCache(){
+            auto store = get();
+            std::lock_guard<std::mutex> lock(store->mMutex);
+            store->release(loaded);
+            store->release(previous);
+        }
+        Magazine* loaded{nullptr};
+        Magazine* previous{nullptr};
+    };
+
+    // both magazines are empty, trade one for a full magazine or fill it from the storage
+    void reload(ThreadCache& cache){
+        std::lock_guard<std::mutex> lock(mMutex);
+        if(!mFull.empty()){
+            mEmpty.push_back(cache.previous);
+            cache.previous = cache.loaded;
+            cache.loaded = mFull.back();
+            mFull.pop_back();
+            return;
+        }
+        auto magazine = cache.loaded;
+        while(magazine->count < MAGAZINE_SIZE){
+            void* slot;
+            try{
+                slot = mStorage[mLast];
+            }catch(const std::bad_alloc&){
+                if(magazine->count) break;
+                throw;
+            }
+            ++mLast;
+            magazine->rounds[magazine->count++] = slot;
+        }
+        // hand out the lowest addresses first
+        std::reverse(magazine->rounds, magazine->rounds + magazine->count);
+    }
+
+    // both magazines are full, give one to the depot in exchange for an empty one
+    void unload(ThreadCache& cache){
+        std::lock_guard<std::mutex> lock(mMutex);
+        mFull.push_back(cache.previous);
+        cache.previous = cache.loaded;
+        cache.loaded = acquireEmpty();
+    }
+
+    Magazine* acquireEmpty(){
+        if(mEmpty.empty()){
+            return new Magazine;
+        }
+        auto magazine = mEmpty.back();
+        mEmpty.pop_back();
+        return magazine;
+    }
+
+    void release(Magazine* magazine){
+        if(magazine->count){
+            mFull.push_back(magazine);
+        }else{
+            mEmpty.push_back(magazine);
+        }
+    }
+
+    std::mutex mMutex;
+    std::vector<Magazine*> mFull;
+    std::vector<Magazine*> mEmpty;
+    size_t mLast{0};
+    StorageType mStorage;
+    MagazineFreeStore() = default;
+    static thread_local ThreadCache sCache;
+};
+
+template <size_t Size, typename StorageType>
+thread_local typename MagazineFreeStore<Size,StorageType>::ThreadCache MagazineFreeStore<Size,StorageType>::sCache;
@@ -0,0 +1,218 @@
+//
+//  MemoryResource.hpp
+//  MemoryManagement
+//
+
+#pragma once
+
+#include <memory_resource>
+#include <new>
+#include "Arena.hpp"
+#include "FreeStore.hpp"
+#include "FreeStorePool.hpp"
+#include "Heap.hpp"
+#include "SizeClassStore.hpp"
+#include "Stack.hpp"
+
+// std::pmr::memory_resource front ends for the stores, so std::pmr containers can use them
+// without being templated on an allocator. Resources that cannot serve a request pass it to
+// their upstream, which can be any memory_resource including the ones here.
+
+// The global heap through Heap, every HeapResource is interchangeable
+class HeapResource : public std::pmr::memory_resource {
+public:
+
+    static HeapResource* get(){
+        static HeapResource sHeapResource;
+        return &sHeapResource;
+    }
+
+protected:
+
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        void* ptr = alignment > DEFAULT_ALIGNMENT ? aligned_allocate(round_up(bytes, alignment), alignment) : Heap<1>::get()->allocate(bytes);
+        if(!ptr) throw std::bad_alloc();
+        return ptr;
+    }
+
+    void do_deallocate(void* ptr, size_t bytes, size_t alignment) override {
+        if(alignment > DEFAULT_ALIGNMENT){
+            aligned_deallocate(ptr);
+        }else{
+            Heap<1>::get()->deallocate(ptr);
+        }
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return dynamic_cast<const HeapResource*>(&other) != nullptr;
+    }
+};
+
+// One fixed size free store, e.g. the nodes of a std::pmr::list. Requests that do not fit a
+// slot go upstream. The store is the singleton unless a FreeStorePool is given.
+template<size_t Size, typename StorageType, template<size_t,typename> class Store = DefaultFreeStore>
+class FreeStoreResource : public std::pmr::memory_resource {
+public:
+
+    typedef Store<Size,StorageType> store_type;
+
+    explicit FreeStoreResource(std::pmr::memory_resource* upstream = HeapResource::get()) :
+    mStore(store_type::get()),
+    mUpstream(upstream)
+    {}
+
+    explicit FreeStoreResource(FreeStorePool& pool, std::pmr::memory_resource* upstream = HeapResource::get()) :
+    mStore(pool.store<store_type>()),
+    mUpstream(upstream)
+    {}
+
+    store_type* store() const { return mStore; }
+    std::pmr::memory_resource* upstream_resource() const { return mUpstream; }
+
+protected:
+
+    static bool fits(size_t bytes, size_t alignment){
+        return bytes <= StorageType::OBJECT_SIZE && alignment <= StorageType::OBJECT_ALIGNMENT;
+    }
+
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        return fits(bytes, alignment) ? mStore->allocate() : mUpstream->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* ptr, size_t bytes, size_t alignment) override {
+        if(fits(bytes, alignment)){
+            mStore->deallocate(ptr);
+        }else{
+            mUpstream->deallocate(ptr, bytes, alignment);
+        }
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        auto resource = dynamic_cast<const FreeStoreResource*>(&other);
+        return resource && resource->mStore == mStore && resource->mUpstream->is_equal(*mUpstream);
+    }
+
+private:
+    store_type* mStore;
+    std::pmr::memory_resource* mUpstream;
+};
+
+// Pooled resource over the size class free stores, the pmr counterpart of SizeClassAllocator.
+// Requests over SizeClasses::MAX_SIZE or aligned beyond their class go upstream.
+template<template<size_t,size_t> class StorageType = BlockListStorage, size_t StorageSize = 65536>
+class PoolResource : public std::pmr::memory_resource {
+public:
+
+    template<size_t Index>
+    using class_store = typename SizeClassStore<StorageType,StorageSize>::template class_store<Index>;
+
+    explicit PoolResource(std::pmr::memory_resource* upstream = HeapResource::get()) :
+    mUpstream(upstream)
+    {
+        fill(typename make_index_list<SizeClasses::COUNT>::type(), nullptr);
+    }
+
+    explicit PoolResource(FreeStorePool& pool, std::pmr::memory_resource* upstream = HeapResource::get()) :
+    mUpstream(upstream)
+    {
+        fill(typename make_index_list<SizeClasses::COUNT>::type(), &pool);
+    }
+
+    PoolResource(const PoolResource&) = delete;
+    PoolResource& operator=(const PoolResource&) = delete;
+
+    std::pmr::memory_resource* upstream_resource() const { return mUpstream; }
+
+protected:
+
+    // the class serving the request, COUNT when it goes upstream
+    size_t index(size_t bytes, size_t alignment) const {
+        if(bytes > SizeClasses::MAX_SIZE) return SizeClasses::COUNT;
+        auto index = SizeClasses::index(bytes ? bytes : 1);
+        return alignment <= mAlignments[index] ? index : SizeClasses::COUNT;
+    }
+
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        auto i = index(bytes, alignment);
+        return i < SizeClasses::COUNT ? mClasses[i]->allocate(1) : mUpstream->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* ptr, size_t bytes, size_t alignment) override {
+        auto i = index(bytes, alignment);
+        if(i < SizeClasses::COUNT){
+            mClasses[i]->deallocate(ptr);
+        }else{
+            mUpstream->deallocate(ptr, bytes, alignment);
+        }
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+private:
+
+    template<size_t... Indices>
+    void fill(index_list<Indices...>, FreeStorePool* pool){
+        IAllocator* classes[] = { (pool ? pool->template store<class_store<Indices>>() : class_store<Indices>::get())... };
+        size_t alignments[] = { StorageType<SizeClasses::size(Indices), StorageSize>::OBJECT_ALIGNMENT... };
+        for(size_t i = 0; i < SizeClasses::COUNT; i++){
+            mClasses[i] = classes[i];
+            mAlignments[i] = alignments[i];
+        }
+    }
+
+    IAllocator* mClasses[SizeClasses::COUNT];
+    size_t mAlignments[SizeClasses::COUNT];
+    std::pmr::memory_resource* mUpstream;
+};
+
+// Monotonic resource over an Arena whose chunks come from upstream. Deallocation is a no-op,
+// arena() gives access to mark() and rewind() and release() hands everything back at once.
+class ArenaResource : public std::pmr::memory_resource, private ChunkSource {
+public:
+
+    explicit ArenaResource(size_t chunkSize = Arena::DEFAULT_CHUNK_SIZE, std::pmr::memory_resource* upstream = HeapResource::get()) :
+    mUpstream(upstream),
+    mArena(chunkSize, this)
+    {}
+
+    Arena& arena(){ return mArena; }
+    void release(){ mArena.release_all(); }
+    std::pmr::memory_resource* upstream_resource() const { return mUpstream; }
+
+protected:
+
+    void* do_allocate(size_t bytes, size_t alignment) override { return mArena.allocate(bytes, alignment); }
+    void do_deallocate(void*, size_t, size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+private:
+
+    void* allocate_chunk(size_t bytes) override { return mUpstream->allocate(bytes, DEFAULT_ALIGNMENT); }
+    void deallocate_chunk(void* chunk, size_t bytes) override { mUpstream->deallocate(chunk, bytes, DEFAULT_ALIGNMENT); }
+
+    std::pmr::memory_resource* mUpstream;
+    Arena mArena;
+};
+
+// LIFO resource over a Stack, frees that are not on top wait for a rewind of the stack
+class StackResource : public std::pmr::memory_resource {
+public:
+
+    explicit StackResource(Stack& stack) : mStack(stack) {}
+
+    Stack& stack(){ return mStack; }
+
+protected:
+
+    void* do_allocate(size_t bytes, size_t alignment) override { return mStack.allocate(bytes, alignment); }
+    void do_deallocate(void* ptr, size_t bytes, size_t) override { mStack.deallocate(ptr, bytes); }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        auto resource = dynamic_cast<const StackResource*>(&other);
+        return resource && &resource->mStack == &mStack;
+    }
+
+private:
+    Stack& mStack;
+};
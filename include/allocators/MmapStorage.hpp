@@ -0,0 +1,97 @@
+//
+//  MmapStorage.hpp
+//  MemoryManagement
+//
+
+#pragma once
+
+#include <algorithm>
+#include <new>
+#include "IAllocator.h"
+#include "VirtualMemory.hpp"
+
+// Storage that reserves ReserveSize bytes of contiguous address space up front and commits it
+// COMMIT_SIZE at a time as the free store carves new slots. Objects are contiguous, so a
+// pointer maps back to its index with a subtraction and a divide.
+template<size_t Size, size_t ReserveSize>
+class MmapStorage {
+public:
+    
+    constexpr static const size_t OBJECT_SIZE = ((Size + sizeof(void *)-1) / sizeof(void *)) * sizeof(void *);
+    constexpr static const size_t OBJECTS_PER_BLOCK = ReserveSize / OBJECT_SIZE;
+    constexpr static const size_t BLOCK_SIZE = OBJECTS_PER_BLOCK * OBJECT_SIZE;
+    constexpr static const size_t COMMIT_SIZE = 64 * 1024;
+    // the reservation is page aligned
+    constexpr static const size_t OBJECT_ALIGNMENT = slot_alignment(OBJECT_SIZE);
+    // slots trimmed as one unit, roughly a commit chunk
+    constexpr static const size_t RELEASE_OBJECTS = COMMIT_SIZE / OBJECT_SIZE ? COMMIT_SIZE / OBJECT_SIZE : 1;
+    
+    MmapStorage() :
+    mReserved(((BLOCK_SIZE + COMMIT_SIZE - 1) / COMMIT_SIZE) * COMMIT_SIZE),
+    mObjects(static_cast<char*>(VirtualMemory::reserve(mReserved)))
+    {
+        if(!mObjects) throw std::bad_alloc();
+    }
+    
+    ~MmapStorage() {
+        VirtualMemory::release(mObjects, mReserved);
+    }
+    
+    MmapStorage(const MmapStorage&) = delete;
+    MmapStorage& operator=(const MmapStorage&) = delete;
+    
+    void* operator[](size_t index) {
+        if(index >= OBJECTS_PER_BLOCK) throw std::bad_alloc();
+        size_t end = (index + 1) * OBJECT_SIZE;
+        if(end > mCommitted){
+            commit(end);
+        }
+        return mObjects + (index*OBJECT_SIZE);
+    }
+    
+    // slots from index to the end of the reservation, which sit back to back in memory
+    size_t contiguous(size_t index){ return index < OBJECTS_PER_BLOCK ? OBJECTS_PER_BLOCK - index : 0; }
+    
+    size_t index_of(const void* ptr) const { return (static_cast<const char*>(ptr) - mObjects) / OBJECT_SIZE; }
+    bool contains(const void* ptr) const { return ptr >= mObjects && ptr < mObjects + BLOCK_SIZE; }
+    
+    size_t capacity(){ return OBJECTS_PER_BLOCK; }
+    size_t max_size(){ return BLOCK_SIZE; }
+    size_t blocks(){ return mCommitted / COMMIT_SIZE; }
+    size_t committed() const { return mCommitted; }
+    
+    // Trimming works in runs of RELEASE_OBJECTS slots. Releasing a run purges the whole pages
+    // inside it, they stay committed and simply fault back in as zero pages when reused.
+    size_t release_units(){ return (mCommitted / OBJECT_SIZE + RELEASE_OBJECTS - 1) / RELEASE_OBJECTS; }
+    void* release_base(size_t unit){
+        size_t offset = unit * RELEASE_OBJECTS * OBJECT_SIZE;
+        return offset < mCommitted ? mObjects + offset : nullptr;
+    }
+    void release(size_t unit){
+        auto page = VirtualMemory::pageSize();
+        size_t begin = unit * RELEASE_OBJECTS * OBJECT_SIZE;
+        size_t end = std::min(begin + RELEASE_OBJECTS * OBJECT_SIZE, mCommitted);
+        begin = ((begin + page - 1) / page) * page;
+        end = (end / page) * page;
+        if(end > begin) VirtualMemory::purge(mObjects + begin, end - begin);
+    }
+    
+private:
+    
+    void commit(size_t end){
+        auto committed = std::min(((end + COMMIT_SIZE - 1) / COMMIT_SIZE) * COMMIT_SIZE, mReserved);
+        if(!VirtualMemory::commit(mObjects + mCommitted, committed - mCommitted)) throw std::bad_alloc();
+        mCommitted = committed;
+    }
+    
+    size_t mReserved;
+    size_t mCommitted{0};
+    char* mObjects;
+};
+
+template<size_t Size, size_t ReserveSize> constexpr const size_t MmapStorage<Size,ReserveSize>::OBJECT_SIZE;
+template<size_t Size, size_t ReserveSize> constexpr const size_t MmapStorage<Size,ReserveSize>::OBJECTS_PER_BLOCK;
+template<size_t Size, size_t ReserveSize> constexpr const size_t MmapStorage<Size,ReserveSize>::BLOCK_SIZE;
+template<size_t Size, size_t ReserveSize> constexpr const size_t MmapStorage<Size,ReserveSize>::COMMIT_SIZE;
+template<size_t Size, size_t ReserveSize> constexpr const size_t MmapStorage<Size,ReserveSize>::OBJECT_ALIGNMENT;
+template<size_t Size, size_t ReserveSize> constexpr const size_t MmapStorage<Size,ReserveSize>::RELEASE_OBJECTS;
@@ -0,0 +1,257 @@
+//
+//  Numa.hpp
+//  MemoryManagement
+//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+#include "FreeStore.hpp"
+#include "VirtualMemory.hpp"
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// node of the calling thread, as opposed to a fixed node
+constexpr int NUMA_LOCAL = -1;
+// nodes the kernel's node masks are sized for here, larger topologies are folded into it
+constexpr int NUMA_MAX_NODES = 1024;
+
+// Node layout of the machine. The system topology asks the kernel directly; tests and
+// experiments install their own with Numa::setTopology.
+class NumaTopology {
+public:
+    virtual ~NumaTopology() = default;
+    // nodes memory can be placed on, always at least 1
+    virtual int nodes() = 0;
+    // node of the cpu the calling thread is running on
+    virtual int current_node() = 0;
+    // place the pages of ptr on node before they are first touched, false if that failed
+    virtual bool bind(void* ptr, size_t bytes, int node) = 0;
+};
+
+// mbind, get_mempolicy and getcpu through syscall(), so there is no libnuma dependency.
+// Kernels without NUMA support and every other platform report a single node.
+class SystemNumaTopology : public NumaTopology {
+public:
+
+    constexpr static const int MAX_NODES = NUMA_MAX_NODES;
+
+    SystemNumaTopology() : mNodes(count()) {}
+
+    int nodes() override { return mNodes; }
+
+    int current_node() override {
+#if defined(__linux__) && defined(SYS_getcpu)
+        unsigned cpu = 0, node = 0;
+        if(mNodes > 1 && syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) return static_cast<int>(node);
+#endif
+        return 0;
+    }
+
+    bool bind(void* ptr, size_t bytes, int node) override {
+        if(node < 0 || node >= MAX_NODES) return false;
+        if(mNodes <= 1) return true;
+#if defined(__linux__) && defined(SYS_mbind)
+        unsigned long mask[MAX_NODES / (8 * sizeof(unsigned long))] = {};
+        mask[node / (8 * sizeof(unsigned long))] = 1UL << (node % (8 * sizeof(unsigned long)));
+        return syscall(SYS_mbind, ptr, bytes, MPOL_BIND, mask, MAX_NODES + 1, 0) == 0;
+#else
+        return false;
+#endif
+    }
+
+private:
+
+    // from <numaif.h>, which comes with libnuma
+    constexpr static const int MPOL_BIND = 2;
+    constexpr static const unsigned long MPOL_F_MEMS_ALLOWED = 1 << 2;
+
+    // highest node this process may allocate on, plus one
+    static int count(){
+#if defined(__linux__) && defined(SYS_get_mempolicy)
+        unsigned long mask[MAX_NODES / (8 * sizeof(unsigned long))] = {};
+        int mode = 0;
+        if(syscall(SYS_get_mempolicy, &mode, mask, MAX_NODES, nullptr, MPOL_F_MEMS_ALLOWED) == 0){
+            int nodes = 1;
+            for(int node = 0; node < MAX_NODES; node++){
+                if(mask[node / (8 * sizeof(unsigned long))] & (1UL << (node % (8 * sizeof(unsigned long))))) nodes = node + 1;
+            }
+            return nodes;
+        }
+#endif
+        return 1;
+    }
+
+    int mNodes;
+};
+
+class Numa {
+public:
+
+    static NumaTopology* topology(){
+        auto topology = sTopology().load(std::memory_order_acquire);
+        return topology ? topology : system();
+    }
+
+    // nullptr goes back to the system topology. Install it before any NUMA storage is used.
+    static void setTopology(NumaTopology* topology){
+        sTopology().store(topology, std::memory_order_release);
+    }
+
+    // node NumaBlocks<NUMA_LOCAL> bind new blocks to on this thread, NUMA_LOCAL by default
+    static int binding(){ return sBinding(); }
+
+    // Binds blocks allocated by this thread to node while in scope
+    class Binding {
+    public:
+        explicit Binding(int node) : mPrevious(sBinding()) { sBinding() = node; }
+        ~Binding(){ sBinding() = mPrevious; }
+        Binding(const Binding&) = delete;
+        Binding& operator=(const Binding&) = delete;
+    private:
+        int mPrevious;
+    };
+
+private:
+
+    static NumaTopology* system(){
+        static SystemNumaTopology sSystem;
+        return &sSystem;
+    }
+
+    static std::atomic<NumaTopology*>& sTopology(){
+        static std::atomic<NumaTopology*> sInstalled{nullptr};
+        return sInstalled;
+    }
+
+    static int& sBinding(){
+        static thread_local int sNode = NUMA_LOCAL;
+        return sNode;
+    }
+};
+
+// One address range reserved per node as it is first used, blocks for that node are carved from
+// it and bound before they are touched. Ranges never move once published, so the node of any
+// block pointer is a lock free range check. Freed blocks are decommitted and reused for blocks
+// of the same size on the same node.
+class NumaRegions {
+public:
+
+    constexpr static const size_t REGION_SIZE = size_t(16) << 30;
+
+    // never destroyed, store singletons hand their blocks back during static destruction
+    static NumaRegions* get(){
+        static NumaRegions* sRegions = new NumaRegions;
+        return sRegions;
+    }
+
+    void* allocate(size_t bytes, int node){
+        bytes = VirtualMemory::roundToPages(bytes);
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto& region = this->region(node);
+        char* block = nullptr;
+        for(auto free = region.freed.begin(); free != region.freed.end(); ++free){
+            if(free->second == bytes){
+                block = free->first;
+                region.freed.erase(free);
+                break;
+            }
+        }
+        if(!block){
+            if(region.top + bytes > region.base + REGION_SIZE) throw std::bad_alloc();
+            block = region.top;
+            region.top += bytes;
+        }
+        if(!VirtualMemory::commit(block, bytes)) throw std::bad_alloc();
+        // a failed bind leaves the block wherever first touch puts it
+        Numa::topology()->bind(block, bytes, node);
+        return block;
+    }
+
+    void deallocate(void* block, size_t bytes){
+        bytes = VirtualMemory::roundToPages(bytes);
+        auto node = node_of(block);
+        if(node < 0) return;
+        VirtualMemory::decommit(block, bytes);
+        std::lock_guard<std::mutex> lock(mMutex);
+        mRegions[node].freed.emplace_back(static_cast<char*>(block), bytes);
+    }
+
+    // node a block pointer was carved for, -1 if it is not from these regions
+    int node_of(const void* ptr) const {
+        auto reserved = mReserved.load(std::memory_order_acquire);
+        for(int node = 0; node < reserved; node++){
+            auto base = mBases[node].load(std::memory_order_acquire);
+            if(base && uintptr_t(ptr) - uintptr_t(base) < REGION_SIZE) return node;
+        }
+        return -1;
+    }
+
+    // nodes are clamped into the topology so a machine with fewer nodes still works
+    static int clamp(int node){
+        auto nodes = std::min(Numa::topology()->nodes(), NUMA_MAX_NODES);
+        return node >= 0 && node < nodes ? node : (node < 0 ? 0 : node % nodes);
+    }
+
+private:
+
+    // guarded by mMutex, only the bases are read without it
+    struct Region {
+        char* base{nullptr};
+        char* top{nullptr};
+        std::vector<std::pair<char*, size_t>> freed;
+    };
+
+    Region& region(int node){
+        auto& region = mRegions[node];
+        if(!region.base){
+            region.base = region.top = static_cast<char*>(VirtualMemory::reserve(REGION_SIZE));
+            if(!region.base) throw std::bad_alloc();
+            mBases[node].store(region.base, std::memory_order_release);
+            if(node >= mReserved.load(std::memory_order_relaxed)) mReserved.store(node + 1, std::memory_order_release);
+        }
+        return region;
+    }
+
+    std::mutex mMutex;
+    Region mRegions[NUMA_MAX_NODES];
+    // published bases, and one past the highest node that has one
+    std::atomic<char*> mBases[NUMA_MAX_NODES]{};
+    std::atomic<int> mReserved{0};
+};
+
+// Block memory bound to Node, or with NUMA_LOCAL to the Numa::Binding in scope and otherwise
+// to the node of the thread that grows the storage. Blocks are page aligned.
+template<int Node = NUMA_LOCAL>
+struct NumaBlocks {
+    static void* allocate(size_t bytes, size_t alignment){
+        if(alignment > VirtualMemory::pageSize()) throw std::bad_alloc();
+        auto node = Node != NUMA_LOCAL ? Node : Numa::binding() != NUMA_LOCAL ? Numa::binding() : Numa::topology()->current_node();
+        return NumaRegions::get()->allocate(bytes, NumaRegions::clamp(node));
+    }
+    static void deallocate(void* block, size_t bytes, size_t alignment){
+        NumaRegions::get()->deallocate(block, bytes);
+    }
+};
+
+// Blocks on the node of the thread that grows the storage, see NumaFreeStore for one per node
+template<size_t Size, size_t BlockSize>
+using NumaBlockListStorage = BasicBlockListStorage<Size, BlockSize, NumaBlocks<NUMA_LOCAL>>;
+
+// Storages pinned to one node, e.g. FreeStoreAllocator<T, NumaNode<1>::BlockListStorage, 65536>
+template<int Node>
+struct NumaNode {
+    template<size_t Size, size_t BlockSize>
+    using BlockListStorage = BasicBlockListStorage<Size, BlockSize, NumaBlocks<Node>>;
+    template<size_t Size, size_t MaxSize>
+    using FixedSizeStorage = BasicFixedSizeStorage<Size, MaxSize, NumaBlocks<Node>>;
+};
@@ -0,0 +1,93 @@
+//
+//  NumaFreeStore.hpp
+//  MemoryManagement
+//
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "Numa.hpp"
+
+// One FreeStore per NUMA node. Allocation serves the calling thread from its own node's store,
+// whose blocks are bound to that node, and a slot always goes back to the store of the node
+// it lives on, so memory never drifts across nodes. On a single node machine it is a FreeStore.
+// StorageType must take its blocks from NumaBlocks<NUMA_LOCAL>, e.g.
+// FreeStoreAllocator<T, NumaBlockListStorage, 65536, NumaFreeStore>. Like FreeStore it is not
+// thread safe; the node of a thread is looked up again every NODE_REFRESH allocations.
+template <size_t Size, typename StorageType>
+class NumaFreeStore : public IAllocator{
+public:
+
+    typedef FreeStore<Size, StorageType> node_store;
+
+    constexpr static const size_t NODE_REFRESH = 1024;
+    // the per thread node cache is shared, the stores are not
+    constexpr static const bool POOLABLE = true;
+
+    NumaFreeStore(){
+        auto nodes = Numa::topology()->nodes();
+        for(int node = 0; node < nodes; node++){
+            // the storage carves its first block as it is constructed
+            Numa::Binding binding(node);
+            mStores.emplace_back(new node_store);
+        }
+    }
+
+    static NumaFreeStore* get(){
+        if(!sNumaFreeStore){
+            sNumaFreeStore.reset(new NumaFreeStore);
+        }
+        return sNumaFreeStore.get();
+    }
+
+    void* allocate(size_t count = 1)override {
+        return allocate_on(node());
+    }
+
+    // allocate from a chosen node's store
+    void* allocate_on(int node){
+        node = NumaRegions::clamp(node);
+        auto store = mStores[node].get();
+        if(store->has_free()) return store->allocate();
+        // the storage may grow, its new block goes on the store's node
+        Numa::Binding binding(node);
+        return store->allocate();
+    }
+
+    void deallocate(void* ptr)override{
+        auto node = NumaRegions::get()->node_of(ptr);
+        mStores[node >= 0 && node < static_cast<int>(mStores.size()) ? node : 0]->deallocate(ptr);
+    }
+
+    size_t capacity() override {
+        size_t total = 0;
+        for(auto& store : mStores){ total += store->capacity(); }
+        return total;
+    }
+
+    int nodes() const { return static_cast<int>(mStores.size()); }
+    node_store* store(int node){ return mStores[NumaRegions::clamp(node)].get(); }
+
+private:
+
+    // the calling thread's node, cached between refreshes
+    static int node(){
+        static thread_local int sNode = 0;
+        static thread_local size_t sUntilRefresh = 0;
+        if(sUntilRefresh-- == 0){
+            sNode = Numa::topology()->current_node();
+            sUntilRefresh = NODE_REFRESH;
+        }
+        return sNode;
+    }
+
+    std::vector<std::unique_ptr<node_store>> mStores;
+    static std::unique_ptr<NumaFreeStore> sNumaFreeStore;
+};
+
+template <size_t Size, typename StorageType>
+constexpr const size_t NumaFreeStore<Size,StorageType>::NODE_REFRESH;
+
+template <size_t Size, typename StorageType>
+std::unique_ptr<NumaFreeStore<Size,StorageType>> NumaFreeStore<Size,StorageType>::sNumaFreeStore = nullptr;
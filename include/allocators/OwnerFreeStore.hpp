@@ -0,0 +1,178 @@
+//
+//  OwnerFreeStore.hpp
+//  MemoryManagement
+//
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <vector>
+#include "FreeStore.hpp"
+
+// Free store where every thread allocates from segments it owns. Freeing on the owning thread
+// is a plain push onto its local list; a slot freed by any other thread is pushed onto the
+// owner's lock free remote list, which the owner takes whole once its local list runs dry.
+// Segments are SEGMENT_SIZE aligned so a slot finds its owner with a mask. When a thread exits
+// its owner record, segments and all, is adopted by the next thread that needs one; remote
+// frees keep landing on it in the meantime. StorageType only sizes the segments.
+template <size_t Size, typename StorageType>
+class OwnerFreeStore : public IAllocator{
+public:
+
+    constexpr static const size_t OBJECT_SIZE = StorageType::OBJECT_SIZE;
+    constexpr static const size_t SEGMENT_SIZE = floor_power_of_two(2 * StorageType::BLOCK_SIZE - 1);
+
+private:
+
+    struct Owner;
+
+    struct Segment {
+        Owner* owner;
+    };
+
+public:
+
+    constexpr static const size_t OBJECTS_OFFSET = round_up(sizeof(Segment),
+        StorageType::OBJECT_ALIGNMENT > CACHE_LINE_SIZE ? StorageType::OBJECT_ALIGNMENT : CACHE_LINE_SIZE);
+    constexpr static const size_t OBJECTS_PER_SEGMENT = (SEGMENT_SIZE - OBJECTS_OFFSET) / OBJECT_SIZE;
+
+    static_assert(OBJECTS_OFFSET < SEGMENT_SIZE && OBJECTS_PER_SEGMENT > 0, "segment too small for Size");
+
+    static OwnerFreeStore* get(){
+        // function local static, so the first call is safe from any thread
+        static OwnerFreeStore sFreeStore;
+        return &sFreeStore;
+    }
+
+    ~OwnerFreeStore(){
+        for(auto segment : mSegments){ aligned_deallocate(segment); }
+        for(auto owner : mOwners){ delete owner; }
+    }
+
+    void* allocate(size_t count = 1)override {
+        auto owner = current();
+        if(!owner->free && owner->remote.load(std::memory_order_relaxed)){
+            owner->free = owner->remote.exchange(nullptr, std::memory_order_acquire);
+        }
+        if(owner->free){
+            auto slot = owner->free;
+            owner->free = *reinterpret_cast<void**>(slot);
+            return slot;
+        }
+        if(owner->next == owner->end){
+            grow(owner);
+        }
+        auto slot = owner->next;
+        owner->next += OBJECT_SIZE;
+        return slot;
+    }
+
+    void deallocate(void* ptr)override{
+        auto owner = segment_of(ptr)->owner;
+        if(owner == sOwner.owner){
+            *reinterpret_cast<void**>(ptr) = owner->free;
+            owner->free = ptr;
+            return;
+        }
+        // multiple producers push, only the owner ever takes, so there is no ABA to guard
+        auto head = owner->remote.load(std::memory_order_relaxed);
+        do{
+            *reinterpret_cast<void**>(ptr) = head;
+        }while(!owner->remote.compare_exchange_weak(head, ptr, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    size_t capacity() override {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mSegments.size() * OBJECTS_PER_SEGMENT;
+    }
+
+    // threads that have owned a part of the store, live or adopted
+    size_t owners(){
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mOwners.size();
+    }
+
+private:
+
+    // Remote frees write remote on every push, so it gets a line of its own away from the owning
+    // thread's fast path, and owners are line aligned so neighbours never share one either.
+    // new honours the over alignment since C++17.
+    struct alignas(CACHE_LINE_SIZE) Owner {
+        void* free{nullptr};        // owning thread only
+        char* next{nullptr};
+        char* end{nullptr};
+        alignas(CACHE_LINE_SIZE) std::atomic<void*> remote{nullptr};
+    };
+
+    static_assert(sizeof(Owner) == 2 * CACHE_LINE_SIZE, "Owner fields and remote list must sit on separate lines");
+
+    // releases the thread's owner for adoption when the thread exits
+    struct OwnerSlot {
+        ~OwnerSlot(){
+            if(owner) get()->abandon(owner);
+        }
+        Owner* owner{nullptr};
+    };
+
+    OwnerFreeStore() = default;
+
+    static Segment* segment_of(void* ptr){
+        return reinterpret_cast<Segment*>(reinterpret_cast<uintptr_t>(ptr) & ~(uintptr_t(SEGMENT_SIZE) - 1));
+    }
+
+    Owner* current(){
+        auto& slot = sOwner;
+        if(!slot.owner){
+            slot.owner = adopt();
+        }
+        return slot.owner;
+    }
+
+    // an orphaned owner if there is one, it keeps its segments, free slots and remote list
+    Owner* adopt(){
+        std::lock_guard<std::mutex> lock(mMutex);
+        if(!mOrphans.empty()){
+            auto owner = mOrphans.back();
+            mOrphans.pop_back();
+            return owner;
+        }
+        mOwners.push_back(new Owner);
+        return mOwners.back();
+    }
+
+    void abandon(Owner* owner){
+        std::lock_guard<std::mutex> lock(mMutex);
+        mOrphans.push_back(owner);
+    }
+
+    void grow(Owner* owner){
+        auto segment = static_cast<Segment*>(aligned_allocate(SEGMENT_SIZE, SEGMENT_SIZE));
+        if(!segment) throw std::bad_alloc();
+        segment->owner = owner;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mSegments.push_back(segment);
+        }
+        owner->next = reinterpret_cast<char*>(segment) + OBJECTS_OFFSET;
+        owner->end = owner->next + OBJECTS_PER_SEGMENT * OBJECT_SIZE;
+    }
+
+    std::mutex mMutex;
+    std::vector<Segment*> mSegments;
+    std::vector<Owner*> mOwners;
+    std::vector<Owner*> mOrphans;
+    static thread_local OwnerSlot sOwner;
+};
+
+template <size_t Size, typename StorageType>
+constexpr const size_t OwnerFreeStore<Size,StorageType>::OBJECT_SIZE;
+template <size_t Size, typename StorageType>
+constexpr const size_t OwnerFreeStore<Size,StorageType>::SEGMENT_SIZE;
+template <size_t Size, typename StorageType>
+constexpr const size_t OwnerFreeStore<Size,StorageType>::OBJECTS_OFFSET;
+template <size_t Size, typename StorageType>
+constexpr const size_t OwnerFreeStore<Size,StorageType>::OBJECTS_PER_SEGMENT;
+template <size_t Size, typename StorageType>
+thread_local typename OwnerFreeStore<Size,StorageType>::OwnerSlot OwnerFreeStore<Size,StorageType>::sOwner;
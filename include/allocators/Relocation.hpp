@@ -0,0 +1,96 @@
+//
+//  Relocation.hpp
+//  MemoryManagement
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Types whose objects can move to a new address with a plain memcpy, the source then counts as
+// destroyed without running its destructor. Trivially copyable types qualify; specialize it
+// for types that only hold pointers to themselves through the heap, e.g. a unique_ptr member.
+template<typename T>
+struct is_trivially_relocatable : std::integral_constant<bool, std::is_trivially_copyable<T>::value> {};
+
+namespace relocation_detail {
+
+    template<typename T>
+    void destroy_n(T* first, size_t count, std::true_type){}
+
+    template<typename T>
+    void destroy_n(T* first, size_t count, std::false_type){
+        for(size_t i = 0; i < count; i++){
+            first[i].~T();
+        }
+    }
+
+    // memmove handles overlapping ranges in either direction
+    template<typename T>
+    void relocate_n(T* first, size_t count, T* dest, std::true_type){
+        if(count) std::memmove(static_cast<void*>(dest), static_cast<const void*>(first), count * sizeof(T));
+    }
+
+    template<typename T>
+    void relocate_n(T* first, size_t count, T* dest, std::false_type){
+        if(dest < first){
+            for(size_t i = 0; i < count; i++){
+                new(dest + i) T(std::move(first[i]));
+                first[i].~T();
+            }
+        }else if(dest > first){
+            for(size_t i = count; i-- > 0;){
+                new(dest + i) T(std::move(first[i]));
+                first[i].~T();
+            }
+        }
+    }
+
+    // value initialization of a trivial type is all zero bytes
+    template<typename T>
+    void construct_n(T* first, size_t count, std::true_type){
+        if(count) std::memset(static_cast<void*>(first), 0, count * sizeof(T));
+    }
+
+    template<typename T>
+    void construct_n(T* first, size_t count, std::false_type){
+        for(size_t i = 0; i < count; i++){
+            new(first + i) T();
+        }
+    }
+}
+
+// Value initializes count objects, a memset for trivial types
+template<typename T>
+void construct_n(T* first, size_t count){
+    relocation_detail::construct_n(first, count, std::integral_constant<bool, std::is_trivial<T>::value>());
+}
+
+// Copies value into count objects, a fill loop the compiler vectorizes for trivially copyable types
+template<typename T>
+void construct_n(T* first, size_t count, const T& value){
+    for(size_t i = 0; i < count; i++){
+        new(first + i) T(value);
+    }
+}
+
+// Destroys count objects, nothing at all for trivially destructible types
+template<typename T>
+void destroy_n(T* first, size_t count){
+    relocation_detail::destroy_n(first, count, std::integral_constant<bool, std::is_trivially_destructible<T>::value>());
+}
+
+// Moves count objects to dest and ends their lifetime at the source. Ranges may overlap.
+template<typename T>
+void relocate_n(T* first, size_t count, T* dest){
+    relocation_detail::relocate_n(first, count, dest, std::integral_constant<bool, is_trivially_relocatable<T>::value>());
+}
+
+template<typename T>
+void relocate(T* from, T* to){
+    relocate_n(from, 1, to);
+}
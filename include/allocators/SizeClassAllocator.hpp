@@ -0,0 +1,59 @@
+//
+//  SizeClassAllocator.hpp
+//  MemoryManagement
+//
+
+#pragma once
+
+#include "AllocatorTraits.hpp"
+#include "SizeClassStore.hpp"
+
+// Allocation policy serving any count from the size class pools, so the small buffers of
+// vectors, strings and hash tables come from pooled runs instead of the system heap.
+template<typename T, template<size_t,size_t> class StorageType = BlockListStorage, size_t StorageSize = 65536>
+class SizeClassAllocator
+{
+public:
+    
+    ALLOCATOR_TRAITS(T)
+    STATELESS_ALLOCATOR_TRAITS
+    
+    typedef SizeClassStore<StorageType,StorageSize> store_type;
+    
+    template<typename U>
+    struct rebind
+    {
+        typedef SizeClassAllocator<U,StorageType,StorageSize> other;
+    };
+    
+    // Default Constructor
+    SizeClassAllocator() = default;
+    
+    // Copy Constructor
+    template<typename U>
+    SizeClassAllocator(SizeClassAllocator<U,StorageType,StorageSize> const& other){}
+    
+    // Allocate memory from the size class of count objects
+    pointer allocate(size_type count = 1, const_pointer hint = 0)
+    {
+        if(count > max_size()){throw std::bad_alloc();}
+        return static_cast<pointer>(store_type::get()->allocate(count * sizeof(T)));
+    }
+    
+    // Return memory to the size class it came from
+    void deallocate(pointer ptr, size_type count = 1)
+    {
+        store_type::get()->deallocate(ptr, count * sizeof(T));
+    }
+    
+    // Max number of objects that can be allocated in one call
+    size_type max_size(void) const {return max_allocations<sizeof(T)>::value;}
+    
+};
+
+// Every instance shares the SizeClassStore singleton
+template<typename T, typename U, template<size_t,size_t> class StorageType, size_t StorageSize>
+bool operator==(SizeClassAllocator<T,StorageType,StorageSize> const& left, SizeClassAllocator<U,StorageType,StorageSize> const& right)
+{
+    return true;
+}
@@ -0,0 +1,103 @@
+//
+//  SizeClassStore.hpp
+//  MemoryManagement
+//
+
+#pragma once
+
+#include <memory>
+#include "FreeStore.hpp"
+#include "Heap.hpp"
+
+// Compile time size class table. Classes step by 8 bytes up to 128, then four classes per
+// power of two up to MAX_SIZE, which keeps worst case internal fragmentation under 25%.
+struct SizeClasses {
+
+    constexpr static const size_t LINEAR_STEP = 8;
+    constexpr static const size_t LINEAR_MAX = 128;
+    constexpr static const size_t LINEAR_CLASSES = LINEAR_MAX / LINEAR_STEP;
+    constexpr static const size_t CLASSES_PER_DOUBLING = 4;
+    constexpr static const size_t MAX_SIZE = 1024;
+
+    // size in bytes of class index
+    constexpr static size_t size(size_t index){
+        return index < LINEAR_CLASSES ? (index + 1) * LINEAR_STEP :
+            (CLASSES_PER_DOUBLING + 1 + (index - LINEAR_CLASSES) % CLASSES_PER_DOUBLING)
+                << ((index - LINEAR_CLASSES) / CLASSES_PER_DOUBLING + log2_floor(LINEAR_MAX / CLASSES_PER_DOUBLING));
+    }
+
+    // smallest class holding bytes, bytes must be in [1, MAX_SIZE]
+    constexpr static size_t index(size_t bytes){
+        return bytes <= LINEAR_MAX ? (bytes + LINEAR_STEP - 1) / LINEAR_STEP - 1 :
+            LINEAR_CLASSES + (log2_floor(bytes - 1) - log2_floor(LINEAR_MAX)) * CLASSES_PER_DOUBLING
+                + ((bytes - 1) >> (log2_floor(bytes - 1) - 2)) - CLASSES_PER_DOUBLING;
+    }
+
+    constexpr static const size_t COUNT = 28;
+};
+
+static_assert(SizeClasses::index(SizeClasses::MAX_SIZE) + 1 == SizeClasses::COUNT, "size class count out of date");
+static_assert(SizeClasses::size(SizeClasses::COUNT - 1) == SizeClasses::MAX_SIZE, "size class table out of date");
+
+template<size_t... Indices> struct index_list {};
+template<size_t N, size_t... Indices> struct make_index_list : make_index_list<N - 1, N - 1, Indices...> {};
+template<size_t... Indices> struct make_index_list<0, Indices...> { typedef index_list<Indices...> type; };
+
+// Variable size front end over the FreeStore singletons. Each request is served by the
+// FreeStore of its size class, so types and arrays of similar size share the same warm blocks;
+// anything over SizeClasses::MAX_SIZE goes to the heap.
+template<template<size_t,size_t> class StorageType = BlockListStorage, size_t StorageSize = 65536>
+class SizeClassStore {
+public:
+
+    template<size_t Index>
+    using class_store = FreeStore<SizeClasses::size(Index), StorageType<SizeClasses::size(Index), StorageSize>>;
+
+    static SizeClassStore* get(){
+        if(!sSizeClassStore){
+            sSizeClassStore.reset(new SizeClassStore);
+        }
+        return sSizeClassStore.get();
+    }
+
+    void* allocate(size_t bytes){
+        if(bytes == 0) bytes = 1;
+        if(bytes > SizeClasses::MAX_SIZE){
+            return Heap<1>::get()->allocate(bytes);
+        }
+        return mClasses[SizeClasses::index(bytes)]->allocate(1);
+    }
+
+    // the size must match the one passed to allocate
+    void deallocate(void* ptr, size_t bytes){
+        if(bytes == 0) bytes = 1;
+        if(bytes > SizeClasses::MAX_SIZE){
+            Heap<1>::get()->deallocate(ptr);
+        }else{
+            mClasses[SizeClasses::index(bytes)]->deallocate(ptr);
+        }
+    }
+
+    // the store backing a request of bytes, nullptr when it goes to the heap
+    IAllocator* store(size_t bytes){
+        return bytes <= SizeClasses::MAX_SIZE ? mClasses[SizeClasses::index(bytes ? bytes : 1)] : nullptr;
+    }
+
+private:
+
+    SizeClassStore(){ fill(typename make_index_list<SizeClasses::COUNT>::type()); }
+
+    template<size_t... Indices>
+    void fill(index_list<Indices...>){
+        IAllocator* classes[] = { class_store<Indices>::get()... };
+        for(size_t i = 0; i < SizeClasses::COUNT; i++){
+            mClasses[i] = classes[i];
+        }
+    }
+
+    IAllocator* mClasses[SizeClasses::COUNT];
+    static std::unique_ptr<SizeClassStore> sSizeClassStore;
+};
+
+template<template<size_t,size_t> class StorageType, size_t StorageSize>
+std::unique_ptr<SizeClassStore<StorageType,StorageSize>> SizeClassStore<StorageType,StorageSize>::sSizeClassStore = nullptr;
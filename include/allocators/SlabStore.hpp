@@ -0,0 +1,192 @@
+//
+//  SlabStore.hpp
+//  MemoryManagement
+//
+
+#pragma once
+
+#include <cstring>
+#include <memory>
+#include <new>
+#include <vector>
+#include "BitOps.hpp"
+#include "IAllocator.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+// Fixed size store that tracks occupancy in a bitmap instead of an intrusive free list. Slabs are
+// SlabSize aligned and start with a header holding the bitmap, so a pointer finds its slab with
+// a mask, freed objects are never written to, and every live object can be visited with
+// for_each_live() without a side registry.
+template<size_t Size, size_t SlabSize = 65536>
+class SlabStore : public IAllocator {
+public:
+
+    static_assert((SlabSize & (SlabSize - 1)) == 0, "SlabSize must be a power of two");
+
+    constexpr static const size_t OBJECT_SIZE = round_up(Size, sizeof(void*));
+    // upper bound used to size the bitmap, the header eats into it
+    constexpr static const size_t MAX_OBJECTS = SlabSize / OBJECT_SIZE;
+    constexpr static const size_t WORDS = (MAX_OBJECTS + 63) / 64;
+
+private:
+
+    struct Slab {
+        Slab* nextPartial;
+        Slab* prevPartial;
+        size_t live;
+        size_t hint;            // no word before this one has a free bit
+        uint64_t bits[WORDS];   // set for live objects
+    };
+
+public:
+
+    constexpr static const size_t OBJECTS_OFFSET = round_up(sizeof(Slab),
+        slot_alignment(OBJECT_SIZE) > CACHE_LINE_SIZE ? slot_alignment(OBJECT_SIZE) : CACHE_LINE_SIZE);
+    constexpr static const size_t OBJECTS_PER_SLAB = OBJECTS_OFFSET < SlabSize ? (SlabSize - OBJECTS_OFFSET) / OBJECT_SIZE : 0;
+
+    static_assert(OBJECTS_PER_SLAB > 0, "SlabSize too small for Size");
+
+    static SlabStore* get(){
+        if(!sSlabStore){
+            sSlabStore.reset(new SlabStore);
+        }
+        return sSlabStore.get();
+    }
+
+    ~SlabStore(){
+        for(auto slab : mSlabs){ aligned_deallocate(slab); }
+    }
+
+    SlabStore(const SlabStore&) = delete;
+    SlabStore& operator=(const SlabStore&) = delete;
+
+    void* allocate(size_t count = 1)override {
+        auto slab = mPartial ? mPartial : grow();
+        auto word = slab->hint;
+        while(slab->bits[word] == ~uint64_t(0)){ ++word; }
+        auto bit = count_trailing_zeros(~slab->bits[word]);
+        slab->bits[word] |= uint64_t(1) << bit;
+        slab->hint = word;
+        if(++slab->live == OBJECTS_PER_SLAB){
+            unlink(slab);
+        }
+        return objects(slab) + (word * 64 + bit) * OBJECT_SIZE;
+    }
+
+    void deallocate(void* ptr)override{
+        auto slab = slab_of(ptr);
+        auto index = (static_cast<char*>(ptr) - objects(slab)) / OBJECT_SIZE;
+        auto word = index / 64;
+        slab->bits[word] &= ~(uint64_t(1) << (index % 64));
+        if(word < slab->hint) slab->hint = word;
+        if(slab->live-- == OBJECTS_PER_SLAB){
+            push(slab);
+        }
+    }
+
+    size_t capacity() override { return mSlabs.size() * OBJECTS_PER_SLAB; }
+
+    bool is_live(const void* ptr) const {
+        auto slab = slab_of(ptr);
+        auto index = (static_cast<const char*>(ptr) - objects(slab)) / OBJECT_SIZE;
+        return (slab->bits[index / 64] >> (index % 64)) & 1;
+    }
+
+    size_t live() const {
+        size_t count = 0;
+        for(auto slab : mSlabs){ count += slab->live; }
+        return count;
+    }
+
+    // Calls f(void*) for every live object, slab by slab in address order within a slab.
+    // Empty stretches of the bitmap are skipped 128 bits at a time.
+    template<typename Function>
+    void for_each_live(Function f){
+        for(auto slab : mSlabs){
+            if(!slab->live) continue;
+            auto base = objects(slab);
+            for(size_t word = next_nonzero(slab->bits, 0); word < WORDS; word = next_nonzero(slab->bits, word + 1)){
+                auto bits = slab->bits[word];
+                while(bits){
+                    auto bit = count_trailing_zeros(bits);
+                    bits &= bits - 1;
+                    f(static_cast<void*>(base + (word * 64 + bit) * OBJECT_SIZE));
+                }
+            }
+        }
+    }
+
+private:
+
+    SlabStore() = default;
+
+    static Slab* slab_of(const void* ptr){
+        return reinterpret_cast<Slab*>(reinterpret_cast<uintptr_t>(ptr) & ~(uintptr_t(SlabSize) - 1));
+    }
+
+    static char* objects(const Slab* slab){
+        return reinterpret_cast<char*>(const_cast<Slab*>(slab)) + OBJECTS_OFFSET;
+    }
+
+    // first word at or after word with a live bit, WORDS when there is none
+    static size_t next_nonzero(const uint64_t* bits, size_t word){
+#if defined(__SSE2__) || defined(_M_X64)
+        const __m128i zero = _mm_setzero_si128();
+        while(word + 2 <= WORDS){
+            auto pair = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bits + word));
+            if(_mm_movemask_epi8(_mm_cmpeq_epi8(pair, zero)) != 0xFFFF) break;
+            word += 2;
+        }
+#endif
+        while(word < WORDS && !bits[word]){ ++word; }
+        return word;
+    }
+
+    // a new slab with an empty bitmap. Bits past the last object stay clear, allocation takes
+    // the lowest free bit and a slab with room always has one below them.
+    Slab* grow(){
+        auto slab = static_cast<Slab*>(aligned_allocate(SlabSize, SlabSize));
+        if(!slab) throw std::bad_alloc();
+        std::memset(slab, 0, sizeof(Slab));
+        mSlabs.push_back(slab);
+        push(slab);
+        return slab;
+    }
+
+    void push(Slab* slab){
+        slab->prevPartial = nullptr;
+        slab->nextPartial = mPartial;
+        if(mPartial) mPartial->prevPartial = slab;
+        mPartial = slab;
+    }
+
+    void unlink(Slab* slab){
+        if(slab->prevPartial){
+            slab->prevPartial->nextPartial = slab->nextPartial;
+        }else{
+            mPartial = slab->nextPartial;
+        }
+        if(slab->nextPartial) slab->nextPartial->prevPartial = slab->prevPartial;
+    }
+
+    std::vector<Slab*> mSlabs;
+    Slab* mPartial{nullptr};
+    static std::unique_ptr<SlabStore> sSlabStore;
+};
+
+template<size_t Size, size_t SlabSize> constexpr const size_t SlabStore<Size,SlabSize>::OBJECT_SIZE;
+template<size_t Size, size_t SlabSize> constexpr const size_t SlabStore<Size,SlabSize>::MAX_OBJECTS;
+template<size_t Size, size_t SlabSize> constexpr const size_t SlabStore<Size,SlabSize>::WORDS;
+template<size_t Size, size_t SlabSize> constexpr const size_t SlabStore<Size,SlabSize>::OBJECTS_OFFSET;
+template<size_t Size, size_t SlabSize> constexpr const size_t SlabStore<Size,SlabSize>::OBJECTS_PER_SLAB;
+
+template<size_t Size, size_t SlabSize>
+std::unique_ptr<SlabStore<Size,SlabSize>> SlabStore<Size,SlabSize>::sSlabStore = nullptr;
+
+// SlabStore sized from the storage's block, usable where a two parameter store is expected,
+// e.g. FreeStoreAllocator<T, BlockListStorage, 65536, SlabFreeStore>
+template<size_t Size, typename StorageType>
+using SlabFreeStore = SlabStore<Size, floor_power_of_two(2 * StorageType::BLOCK_SIZE - 1)>;
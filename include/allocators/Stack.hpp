@@ -0,0 +1,102 @@
+//
+//  Stack.hpp
+//  MemoryManagement
+//
+
+#pragma once
+
+#include <new>
+#include "IAllocator.h"
+
+// Fixed size LIFO region. Allocation bumps the top, freeing the most recent allocation pops it
+// and anything else is reclaimed when the top is rewound to an earlier marker. Running out of
+// room throws std::bad_alloc rather than growing, so the size is set once from telemetry.
+class Stack {
+public:
+
+    typedef size_t Marker;
+
+    explicit Stack(size_t bytes) :
+    mBegin(static_cast<char*>(::operator new(bytes))),
+    mCapacity(bytes)
+    {}
+
+    ~Stack(){ ::operator delete(mBegin); }
+
+    Stack(const Stack&) = delete;
+    Stack& operator=(const Stack&) = delete;
+
+    void* allocate(size_t bytes, size_t alignment = DEFAULT_ALIGNMENT){
+        auto start = round_up(reinterpret_cast<uintptr_t>(mBegin) + mTop, alignment) - reinterpret_cast<uintptr_t>(mBegin);
+        if(start + bytes > mCapacity) throw std::bad_alloc();
+        mTop = start + bytes;
+        if(mTop > mHighWater) mHighWater = mTop;
+        return mBegin + start;
+    }
+
+    // pops ptr when it is the most recent allocation, otherwise it waits for a rewind
+    void deallocate(void* ptr, size_t bytes){
+        if(static_cast<char*>(ptr) + bytes == mBegin + mTop){
+            mTop = static_cast<char*>(ptr) - mBegin;
+        }
+    }
+
+    Marker mark() const { return mTop; }
+    void rewind(Marker marker){ mTop = marker; }
+    void reset(){ mTop = 0; }
+
+    size_t used() const { return mTop; }
+    size_t capacity() const { return mCapacity; }
+    size_t high_water_mark() const { return mHighWater; }
+
+    // Rewinds the stack to where it was when the scope opened
+    class Scope {
+    public:
+        explicit Scope(Stack& stack) : mStack(stack), mMarker(stack.mark()) {}
+        ~Scope(){ mStack.rewind(mMarker); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        Stack& mStack;
+        Marker mMarker;
+    };
+
+private:
+    char* mBegin;
+    size_t mCapacity;
+    size_t mTop{0};
+    size_t mHighWater{0};
+};
+
+// Two stacks used on alternate frames. flip() starts a new frame on the other stack, so data
+// allocated during the previous frame stays valid for one more frame before it is overwritten.
+class FrameStacks {
+public:
+
+    explicit FrameStacks(size_t bytesPerFrame) :
+    mEven(bytesPerFrame),
+    mOdd(bytesPerFrame)
+    {}
+
+    FrameStacks(const FrameStacks&) = delete;
+    FrameStacks& operator=(const FrameStacks&) = delete;
+
+    void flip(){
+        ++mFrame;
+        current().reset();
+    }
+
+    Stack& current(){ return mFrame & 1 ? mOdd : mEven; }
+    Stack& previous(){ return mFrame & 1 ? mEven : mOdd; }
+
+    size_t frame() const { return mFrame; }
+    // largest single frame seen so far
+    size_t high_water_mark() const {
+        return mEven.high_water_mark() > mOdd.high_water_mark() ? mEven.high_water_mark() : mOdd.high_water_mark();
+    }
+
+private:
+    Stack mEven;
+    Stack mOdd;
+    size_t mFrame{0};
+};
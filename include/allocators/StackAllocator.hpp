@@ -0,0 +1,106 @@
+//
+//  StackAllocator.hpp
+//  MemoryManagement
+//
+
+#pragma once
+
+#include "AllocatorTraits.hpp"
+#include "Stack.hpp"
+
+// Allocation policy drawing from a Stack owned by the caller. Containers should be destroyed
+// in reverse order of creation, or simply before the Stack::Scope they were built in closes.
+template<typename T>
+class StackAllocator
+{
+public:
+    
+    ALLOCATOR_TRAITS(T)
+    STATEFUL_ALLOCATOR_TRAITS
+    
+    template<typename U>
+    struct rebind
+    {
+        typedef StackAllocator<U> other;
+    };
+    
+    StackAllocator(Stack& stack) : mStack(&stack) {}
+    
+    // Copy Constructor, rebound copies share the stack
+    template<typename U>
+    StackAllocator(StackAllocator<U> const& other) : mStack(other.stack()) {}
+    
+    pointer allocate(size_type count = 1, const_pointer hint = 0)
+    {
+        if(count > max_size()){throw std::bad_alloc();}
+        return static_cast<pointer>(mStack->allocate(count * sizeof(T), alignof(T)));
+    }
+    
+    // Pops the allocation when it is on top of the stack
+    void deallocate(pointer ptr, size_type count = 1)
+    {
+        mStack->deallocate(ptr, count * sizeof(T));
+    }
+    
+    // Max number of objects that can be allocated in one call
+    size_type max_size(void) const {return max_allocations<sizeof(T)>::value;}
+    
+    Stack* stack() const { return mStack; }
+    
+private:
+    Stack* mStack;
+};
+
+// Equal when sharing the same stack
+template<typename T, typename U>
+bool operator==(StackAllocator<T> const& left, StackAllocator<U> const& right)
+{
+    return left.stack() == right.stack();
+}
+
+// Allocation policy for per tick scratch data. Allocations land on the current frame's stack
+// and stay readable through the following frame; nothing is freed individually.
+template<typename T>
+class FrameAllocator
+{
+public:
+    
+    ALLOCATOR_TRAITS(T)
+    STATEFUL_ALLOCATOR_TRAITS
+    
+    template<typename U>
+    struct rebind
+    {
+        typedef FrameAllocator<U> other;
+    };
+    
+    FrameAllocator(FrameStacks& frames) : mFrames(&frames) {}
+    
+    // Copy Constructor, rebound copies share the frames
+    template<typename U>
+    FrameAllocator(FrameAllocator<U> const& other) : mFrames(other.frames()) {}
+    
+    pointer allocate(size_type count = 1, const_pointer hint = 0)
+    {
+        if(count > max_size()){throw std::bad_alloc();}
+        return static_cast<pointer>(mFrames->current().allocate(count * sizeof(T), alignof(T)));
+    }
+    
+    // Nothing to do, the frame is reclaimed two flips later
+    void deallocate(pointer ptr, size_type count = 1) {}
+    
+    // Max number of objects that can be allocated in one call
+    size_type max_size(void) const {return max_allocations<sizeof(T)>::value;}
+    
+    FrameStacks* frames() const { return mFrames; }
+    
+private:
+    FrameStacks* mFrames;
+};
+
+// Equal when sharing the same frame stacks
+template<typename T, typename U>
+bool operator==(FrameAllocator<T> const& left, FrameAllocator<U> const& right)
+{
+    return left.frames() == right.frames();
+}
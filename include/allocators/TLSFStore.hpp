@@ -0,0 +1,225 @@
+//
+//  TLSFStore.hpp
+//  MemoryManagement
+//
+
+#pragma once
+
+#include <memory>
+#include <new>
+#include "BitOps.hpp"
+#include "IAllocator.h"
+#include "VirtualMemory.hpp"
+
+// Two Level Segregated Fit allocator over one PoolSize mapping. Free blocks are binned first by
+// power of two and then into SL_COUNT linear ranges within it; a bitmap per level lets
+// allocate find a fitting non empty bin with two bit scans, and deallocate merges with both
+// physical neighbours straight away, so both are O(1) with no loops over blocks or bins.
+template<size_t PoolSize>
+class TLSFStore : public IAllocator {
+public:
+
+    constexpr static const size_t ALIGNMENT = 16;
+    constexpr static const size_t SL_SHIFT = 4;
+    constexpr static const size_t SL_COUNT = size_t(1) << SL_SHIFT;
+    // sizes below SMALL_SIZE share the first level and are binned linearly by ALIGNMENT
+    constexpr static const size_t FL_SHIFT = SL_SHIFT + 4;
+    constexpr static const size_t SMALL_SIZE = size_t(1) << FL_SHIFT;
+    constexpr static const size_t FL_COUNT = log2_floor(PoolSize) - FL_SHIFT + 2;
+
+    static_assert(PoolSize >= 4096 && PoolSize % ALIGNMENT == 0, "PoolSize too small");
+    static_assert(FL_COUNT <= 64, "too many first level bins for the bitmap");
+
+    static TLSFStore* get(){
+        if(!sTLSFStore){
+            sTLSFStore.reset(new TLSFStore);
+        }
+        return sTLSFStore.get();
+    }
+
+    ~TLSFStore(){
+        VirtualMemory::release(mPool, PoolSize);
+    }
+
+    TLSFStore(const TLSFStore&) = delete;
+    TLSFStore& operator=(const TLSFStore&) = delete;
+
+    // bytes, aligned to ALIGNMENT
+    void* allocate(size_t bytes)override {
+        if(bytes > PoolSize) throw std::bad_alloc();
+        auto size = adjust(bytes);
+        auto block = find(size);
+        if(!block) throw std::bad_alloc();
+        remove(block);
+        // give back the tail when it is big enough to be a block of its own
+        if(block->size() >= size + sizeof(Header) + MIN_PAYLOAD){
+            auto rest = reinterpret_cast<Header*>(block->payload() + size);
+            rest->setSize(block->size() - size - sizeof(Header), true);
+            rest->prevPhys = block;
+            rest->next()->prevPhys = rest;
+            block->setSize(size, false);
+            insert(rest);
+        }else{
+            block->setFree(false);
+        }
+        mFree -= block->size() + sizeof(Header);
+        return block->payload();
+    }
+
+    void deallocate(void* ptr)override{
+        auto block = reinterpret_cast<Header*>(static_cast<char*>(ptr) - sizeof(Header));
+        mFree += block->size() + sizeof(Header);
+        block->setFree(true);
+        auto prev = block->prevPhys;
+        if(prev && prev->isFree()){
+            remove(prev);
+            prev->setSize(prev->size() + sizeof(Header) + block->size(), true);
+            block = prev;
+            block->next()->prevPhys = block;
+        }
+        auto next = block->next();
+        if(next->isFree()){
+            remove(next);
+            block->setSize(block->size() + sizeof(Header) + next->size(), true);
+            block->next()->prevPhys = block;
+        }
+        insert(block);
+    }
+
+    // free bytes, including the headers free blocks would give up when split
+    size_t capacity() override { return mFree; }
+
+    // The pool is mapped lazily, so the first use of each page takes a page fault. Real time
+    // users should touch the whole pool up front to keep that out of allocate.
+    void prefault(){
+        auto page = VirtualMemory::pageSize();
+        for(size_t offset = 0; offset < PoolSize; offset += page){
+            auto byte = reinterpret_cast<volatile char*>(mPool + offset);
+            *byte = *byte;
+        }
+    }
+
+private:
+
+    // physical block header, the payload follows it and free blocks thread the bin list through it
+    struct Header {
+        size_t sizeAndFlags;
+        Header* prevPhys;
+
+        size_t size() const { return sizeAndFlags & ~size_t(FREE); }
+        bool isFree() const { return sizeAndFlags & FREE; }
+        void setSize(size_t size, bool free){ sizeAndFlags = size | (free ? FREE : 0); }
+        void setFree(bool free){ setSize(size(), free); }
+        char* payload(){ return reinterpret_cast<char*>(this + 1); }
+        Header* next(){ return reinterpret_cast<Header*>(payload() + size()); }
+        Header*& nextFree(){ return reinterpret_cast<Header**>(payload())[0]; }
+        Header*& prevFree(){ return reinterpret_cast<Header**>(payload())[1]; }
+    };
+
+    constexpr static const size_t FREE = 1;
+    constexpr static const size_t MIN_PAYLOAD = 2 * sizeof(void*);
+
+    static_assert(sizeof(Header) == ALIGNMENT, "header must keep payloads aligned");
+
+    // one free block spanning the pool, followed by an empty used block so next() always exists
+    TLSFStore() :
+    mPool(static_cast<char*>(VirtualMemory::map(PoolSize)))
+    {
+        if(!mPool) throw std::bad_alloc();
+        for(auto& bins : mBins){
+            for(auto& bin : bins){ bin = nullptr; }
+        }
+        auto block = reinterpret_cast<Header*>(mPool);
+        block->setSize(PoolSize - 2 * sizeof(Header), true);
+        block->prevPhys = nullptr;
+        auto sentinel = block->next();
+        sentinel->setSize(0, false);
+        sentinel->prevPhys = block;
+        mFree = block->size() + sizeof(Header);
+        insert(block);
+    }
+
+    static size_t adjust(size_t bytes){
+        auto size = round_up(bytes ? bytes : 1, ALIGNMENT);
+        return size < MIN_PAYLOAD ? MIN_PAYLOAD : size;
+    }
+
+    // bin holding blocks of exactly size
+    static void mapping(size_t size, size_t& fl, size_t& sl){
+        if(size < SMALL_SIZE){
+            fl = 0;
+            sl = size / ALIGNMENT;
+        }else{
+            auto top = find_last_set(size);
+            fl = top - FL_SHIFT + 1;
+            sl = (size >> (top - SL_SHIFT)) ^ SL_COUNT;
+        }
+    }
+
+    // smallest non empty bin whose blocks are all at least size
+    Header* find(size_t size){
+        if(size >= SMALL_SIZE){
+            // round up to the next bin boundary so any block in the bin fits
+            size += (size_t(1) << (find_last_set(size) - SL_SHIFT)) - 1;
+        }
+        size_t fl, sl;
+        mapping(size, fl, sl);
+        if(fl >= FL_COUNT) return nullptr;
+        auto slMap = mSecondLevel[fl] & (~uint64_t(0) << sl);
+        if(!slMap){
+            auto flMap = fl + 1 < 64 ? mFirstLevel & (~uint64_t(0) << (fl + 1)) : 0;
+            if(!flMap) return nullptr;
+            fl = count_trailing_zeros(flMap);
+            slMap = mSecondLevel[fl];
+        }
+        return mBins[fl][count_trailing_zeros(slMap)];
+    }
+
+    void insert(Header* block){
+        size_t fl, sl;
+        mapping(block->size(), fl, sl);
+        auto& head = mBins[fl][sl];
+        block->nextFree() = head;
+        block->prevFree() = nullptr;
+        if(head) head->prevFree() = block;
+        head = block;
+        mFirstLevel |= uint64_t(1) << fl;
+        mSecondLevel[fl] |= uint64_t(1) << sl;
+    }
+
+    void remove(Header* block){
+        size_t fl, sl;
+        mapping(block->size(), fl, sl);
+        auto next = block->nextFree();
+        auto prev = block->prevFree();
+        if(next) next->prevFree() = prev;
+        if(prev){
+            prev->nextFree() = next;
+        }else{
+            mBins[fl][sl] = next;
+            if(!next){
+                mSecondLevel[fl] &= ~(uint64_t(1) << sl);
+                if(!mSecondLevel[fl]) mFirstLevel &= ~(uint64_t(1) << fl);
+            }
+        }
+    }
+
+    char* mPool;
+    uint64_t mFirstLevel{0};
+    uint64_t mSecondLevel[FL_COUNT] = {};
+    Header* mBins[FL_COUNT][SL_COUNT];
+    size_t mFree{0};
+    static std::unique_ptr<TLSFStore> sTLSFStore;
+};
+
+template<size_t PoolSize> constexpr const size_t TLSFStore<PoolSize>::ALIGNMENT;
+template<size_t PoolSize> constexpr const size_t TLSFStore<PoolSize>::SL_SHIFT;
+template<size_t PoolSize> constexpr const size_t TLSFStore<PoolSize>::SL_COUNT;
+template<size_t PoolSize> constexpr const size_t TLSFStore<PoolSize>::FL_SHIFT;
+template<size_t PoolSize> constexpr const size_t TLSFStore<PoolSize>::SMALL_SIZE;
+template<size_t PoolSize> constexpr const size_t TLSFStore<PoolSize>::FL_COUNT;
+template<size_t PoolSize> constexpr const size_t TLSFStore<PoolSize>::FREE;
+template<size_t PoolSize> constexpr const size_t TLSFStore<PoolSize>::MIN_PAYLOAD;
+
+template<size_t PoolSize>
+std::unique_ptr<TLSFStore<PoolSize>> TLSFStore<PoolSize>::sTLSFStore = nullptr;
@@ -0,0 +1,122 @@
+//
+//  ThreadRangeFreeStore.hpp
+//  MemoryManagement
+//
+
+#pragma once
+
+#include <algorithm>
+#include <mutex>
+#include "FreeStore.hpp"
+
+// Free store that hands each thread its own whole cache lines. A thread carves fresh slots from
+// a private run that starts and ends on a line boundary, so objects carved by different threads
+// never share a line. Only taking a new run from the storage takes a lock. Freed slots go on the
+// freeing thread's own list, and a thread's leftovers are adopted by the next thread that runs
+// dry once it exits. Reused slots can therefore sit on another thread's lines when objects are
+// freed by a thread other than the one that allocated them; OwnerFreeStore returns those frees
+// to their owner instead.
+template <size_t Size, typename StorageType>
+class ThreadRangeFreeStore : public IAllocator{
+public:
+
+    // slots per repeat of the line pattern, a run of a multiple of this ends on a line boundary
+    constexpr static const size_t LINE_PERIOD = CACHE_LINE_SIZE /
+        (lowest_set_bit(StorageType::OBJECT_SIZE) < CACHE_LINE_SIZE ? lowest_set_bit(StorageType::OBJECT_SIZE) : CACHE_LINE_SIZE);
+    // runs of at least 16 lines
+    constexpr static const size_t RUN_OBJECTS = round_up(16 * CACHE_LINE_SIZE / StorageType::OBJECT_SIZE + 1, LINE_PERIOD);
+
+    static_assert(StorageType::OBJECTS_PER_BLOCK % LINE_PERIOD == 0, "blocks must hold whole line periods");
+
+    static ThreadRangeFreeStore* get(){
+        // function local static, so the first call is safe from any thread
+        static ThreadRangeFreeStore sFreeStore;
+        return &sFreeStore;
+    }
+
+    void* allocate(size_t count = 1)override {
+        auto& range = sRange;
+        if(!range.free && range.next == range.end){
+            refill(range);
+        }
+        if(range.free){
+            auto slot = range.free;
+            range.free = *reinterpret_cast<void**>(slot);
+            return slot;
+        }
+        auto slot = range.next;
+        range.next += StorageType::OBJECT_SIZE;
+        return slot;
+    }
+
+    // a slot allocated by another thread is reused here, no longer on a line of its own
+    void deallocate(void* ptr)override{
+        auto& range = sRange;
+        *reinterpret_cast<void**>(ptr) = range.free;
+        range.free = ptr;
+    }
+
+    size_t capacity() override {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mStorage.capacity();
+    }
+
+    size_t max_size(){
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mStorage.max_size();
+    }
+
+private:
+
+    struct ThreadRange {
+        // leave whatever this thread still holds for the next thread that runs dry
+        ~ThreadRange(){
+            if(!free && next == end) return;
+            auto store = get();
+            std::lock_guard<std::mutex> lock(store->mMutex);
+            for(; next != end; next += StorageType::OBJECT_SIZE){
+                *reinterpret_cast<void**>(next) = free;
+                free = next;
+            }
+            while(free){
+                auto slot = free;
+                free = *reinterpret_cast<void**>(slot);
+                *reinterpret_cast<void**>(slot) = store->mOrphans;
+                store->mOrphans = slot;
+            }
+        }
+        void* free{nullptr};
+        char* next{nullptr};
+        char* end{nullptr};
+    };
+
+    // adopt orphaned slots if there are any, otherwise take a fresh line aligned run
+    void refill(ThreadRange& range){
+        std::lock_guard<std::mutex> lock(mMutex);
+        if(mOrphans){
+            range.free = mOrphans;
+            mOrphans = nullptr;
+            return;
+        }
+        size_t run = std::min(RUN_OBJECTS, mStorage.contiguous(mLast));
+        if(run == 0) throw std::bad_alloc();
+        mStorage[mLast + run - 1];
+        range.next = static_cast<char*>(mStorage[mLast]);
+        range.end = range.next + run * StorageType::OBJECT_SIZE;
+        mLast += run;
+    }
+
+    std::mutex mMutex;
+    void* mOrphans{nullptr};
+    size_t mLast{0};
+    StorageType mStorage;
+    ThreadRangeFreeStore() = default;
+    static thread_local ThreadRange sRange;
+};
+
+template <size_t Size, typename StorageType>
+constexpr const size_t ThreadRangeFreeStore<Size,StorageType>::LINE_PERIOD;
+template <size_t Size, typename StorageType>
+constexpr const size_t ThreadRangeFreeStore<Size,StorageType>::RUN_OBJECTS;
+template <size_t Size, typename StorageType>
+thread_local typename ThreadRangeFreeStore<Size,StorageType>::ThreadRange ThreadRangeFreeStore<Size,StorageType>::sRange;
@@ -0,0 +1,94 @@
+//
+//  VirtualMemory.hpp
+//  MemoryManagement
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Thin platform layer over address space reservation. Reserved ranges cost no physical memory
+// until committed, and committed pages are only backed once they are first touched.
+struct VirtualMemory {
+
+    static size_t pageSize(){
+#if defined(_WIN32)
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return info.dwPageSize;
+#else
+        static const size_t sPageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        return sPageSize;
+#endif
+    }
+
+    static size_t roundToPages(size_t bytes){
+        auto page = pageSize();
+        return ((bytes + page - 1) / page) * page;
+    }
+
+    // reserve an inaccessible range, nullptr on failure
+    static void* reserve(size_t bytes){
+#if defined(_WIN32)
+        return VirtualAlloc(nullptr, bytes, MEM_RESERVE, PAGE_NOACCESS);
+#else
+        auto ptr = mmap(nullptr, bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        return ptr == MAP_FAILED ? nullptr : ptr;
+#endif
+    }
+
+    // reserve and commit in one step, pages are zero filled by the system on first touch
+    static void* map(size_t bytes){
+#if defined(_WIN32)
+        return VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+        auto ptr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        return ptr == MAP_FAILED ? nullptr : ptr;
+#endif
+    }
+
+    // make a page aligned part of a reservation readable and writable
+    static bool commit(void* ptr, size_t bytes){
+#if defined(_WIN32)
+        return VirtualAlloc(ptr, bytes, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+#else
+        return mprotect(ptr, bytes, PROT_READ | PROT_WRITE) == 0;
+#endif
+    }
+
+    // give the physical pages back, the range stays reserved
+    static void decommit(void* ptr, size_t bytes){
+#if defined(_WIN32)
+        VirtualFree(ptr, bytes, MEM_DECOMMIT);
+#else
+        madvise(ptr, bytes, MADV_DONTNEED);
+        mprotect(ptr, bytes, PROT_NONE);
+#endif
+    }
+
+    // drop the physical pages but keep the range usable, it reads back as zero once touched
+    static void purge(void* ptr, size_t bytes){
+#if defined(_WIN32)
+        VirtualFree(ptr, bytes, MEM_DECOMMIT);
+        VirtualAlloc(ptr, bytes, MEM_COMMIT, PAGE_READWRITE);
+#else
+        madvise(ptr, bytes, MADV_DONTNEED);
+#endif
+    }
+
+    static void release(void* ptr, size_t bytes){
+#if defined(_WIN32)
+        VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+        munmap(ptr, bytes);
+#endif
+    }
+};
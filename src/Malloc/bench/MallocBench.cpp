@@ -0,0 +1,180 @@
+//
+//  MallocBench.cpp
+//  MemoryManagement
+//
+
+// Synthetic server workloads against whatever malloc the process has. Run it as is for glibc
+// and again with LD_PRELOAD=libpoolmalloc.so to compare, the malloc_compare target does both.
+//
+//   malloc_bench [threads] [seconds per workload]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    // mostly small, occasionally large, roughly what request parsing and small strings look like
+    size_t requestSize(std::minstd_rand& random){
+        auto roll = random() % 100;
+        if(roll < 60) return 8 + random() % 120;
+        if(roll < 90) return 128 + random() % 896;
+        if(roll < 99) return 1024 + random() % 3072;
+        return 4096 + random() % 60000;
+    }
+
+    void touch(void* ptr, size_t bytes){
+        memset(ptr, 0x5A, bytes < 64 ? bytes : 64);
+    }
+
+    // a request allocates a few hundred objects and frees them all when the response is sent
+    size_t requests(int seed, const std::atomic<bool>& stop){
+        std::minstd_rand random(seed);
+        std::vector<void*> live;
+        size_t operations = 0;
+        while(!stop.load(std::memory_order_relaxed)){
+            auto count = 50 + random() % 200;
+            for(size_t i = 0; i < count; i++){
+                auto bytes = requestSize(random);
+                live.push_back(malloc(bytes));
+                touch(live.back(), bytes);
+            }
+            for(auto ptr : live){ free(ptr); }
+            operations += live.size();
+            live.clear();
+        }
+        return operations;
+    }
+
+    // a long lived cache whose entries are replaced at random, the working set stays fixed
+    size_t cache(int seed, const std::atomic<bool>& stop){
+        std::minstd_rand random(seed);
+        std::vector<void*> entries(20000, nullptr);
+        size_t operations = 0;
+        while(!stop.load(std::memory_order_relaxed)){
+            for(int i = 0; i < 1000; i++){
+                auto& entry = entries[random() % entries.size()];
+                free(entry);
+                auto bytes = requestSize(random);
+                entry = malloc(bytes);
+                touch(entry, bytes);
+            }
+            operations += 1000;
+        }
+        for(auto entry : entries){ free(entry); }
+        return operations;
+    }
+
+    // objects allocated by one thread and freed by another, like buffers passed to a writer
+    struct Handoff {
+        std::mutex lock;
+        std::condition_variable ready;
+        std::deque<std::vector<void*>> batches;
+    };
+
+    size_t handoffProducer(int seed, Handoff& handoff, const std::atomic<bool>& stop){
+        std::minstd_rand random(seed);
+        size_t operations = 0;
+        while(!stop.load(std::memory_order_relaxed)){
+            std::vector<void*> batch(256);
+            for(auto& ptr : batch){
+                auto bytes = requestSize(random);
+                ptr = malloc(bytes);
+                touch(ptr, bytes);
+            }
+            operations += batch.size();
+            std::unique_lock<std::mutex> lock(handoff.lock);
+            // keep the queue bounded so the run measures throughput, not growth
+            while(handoff.batches.size() > 64 && !stop.load(std::memory_order_relaxed)){
+                lock.unlock();
+                std::this_thread::yield();
+                lock.lock();
+            }
+            handoff.batches.push_back(std::move(batch));
+            handoff.ready.notify_one();
+        }
+        return operations;
+    }
+
+    void handoffConsumer(Handoff& handoff, const std::atomic<bool>& stop){
+        for(;;){
+            std::vector<void*> batch;
+            {
+                std::unique_lock<std::mutex> lock(handoff.lock);
+                handoff.ready.wait_for(lock, std::chrono::milliseconds(10), [&]{ return !handoff.batches.empty(); });
+                if(handoff.batches.empty()){
+                    if(stop.load()) return;
+                    continue;
+                }
+                batch = std::move(handoff.batches.front());
+                handoff.batches.pop_front();
+            }
+            for(auto ptr : batch){ free(ptr); }
+        }
+    }
+
+    size_t residentKiB(){
+        long pages = 0, resident = 0;
+        if(FILE* statm = fopen("/proc/self/statm", "r")){
+            if(fscanf(statm, "%ld %ld", &pages, &resident) != 2) resident = 0;
+            fclose(statm);
+        }
+        return resident * (sysconf(_SC_PAGESIZE) / 1024);
+    }
+
+    size_t peakKiB(){
+        rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss;
+    }
+
+    template<typename Work>
+    void run(const char* name, int threads, double seconds, Work work){
+        std::atomic<bool> stop{false};
+        std::atomic<size_t> operations{0};
+        std::vector<std::thread> workers;
+        auto start = std::chrono::steady_clock::now();
+        for(int i = 0; i < threads; i++){
+            workers.emplace_back([&, i]{ operations += work(i + 1, stop); });
+        }
+        std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+        auto resident = residentKiB();
+        stop = true;
+        for(auto& worker : workers){ worker.join(); }
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        printf("%-10s %2d threads %10.2f Mops/s  rss %8zu KiB  peak %8zu KiB\n",
+               name, threads, operations / elapsed / 1e6, resident, peakKiB());
+    }
+}
+
+int main(int argc, char** argv){
+    int threads = argc > 1 ? atoi(argv[1]) : int(std::thread::hardware_concurrency());
+    double seconds = argc > 2 ? atof(argv[2]) : 2.0;
+    if(threads < 1) threads = 1;
+    printf("malloc: %s\n", getenv("LD_PRELOAD") ? getenv("LD_PRELOAD") : "glibc");
+
+    run("requests", threads, seconds, requests);
+    run("cache", threads, seconds, cache);
+
+    Handoff handoff;
+    std::atomic<bool> consumersStop{false};
+    std::vector<std::thread> consumers;
+    for(int i = 0; i < (threads + 1) / 2; i++){
+        consumers.emplace_back([&]{ handoffConsumer(handoff, consumersStop); });
+    }
+    run("handoff", threads, seconds, [&](int seed, const std::atomic<bool>& stop){ return handoffProducer(seed, handoff, stop); });
+    consumersStop = true;
+    handoff.ready.notify_all();
+    for(auto& consumer : consumers){ consumer.join(); }
+    return 0;
+}
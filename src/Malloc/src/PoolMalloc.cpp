@@ -0,0 +1,366 @@
+//
+//  PoolMalloc.cpp
+//  MemoryManagement
+//
+
+// malloc replacement for LD_PRELOAD. Requests up to SizeClasses::MAX_SIZE are served from
+// per size class regions carved out of one address space reservation, so free() finds the
+// class of any pointer with a subtraction and a divide. Each thread caches a few slots per class
+// and trades them with the shared free lists a batch at a time. Larger and foreign pointers
+// go to glibc's own allocator.
+//
+// Nothing here may allocate through malloc: regions come from mmap, thread caches live in
+// static TLS and are flushed by a pthread key destructor when their thread exits.
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include "SizeClassStore.hpp"
+#include "VirtualMemory.hpp"
+
+extern "C" {
+    void* __libc_malloc(size_t bytes);
+    void* __libc_calloc(size_t count, size_t bytes);
+    void* __libc_realloc(void* ptr, size_t bytes);
+    void* __libc_memalign(size_t alignment, size_t bytes);
+    void __libc_free(void* ptr);
+}
+
+namespace {
+
+    constexpr size_t CLASS_COUNT = SizeClasses::COUNT;
+    // address space per class, reserved but only committed as it is carved
+    constexpr size_t REGION_SIZE = size_t(1) << 32;
+    constexpr size_t COMMIT_SIZE = 1024 * 1024;
+    // slots moved between a thread cache and the shared list at once
+    constexpr size_t CACHE_BYTES = 16 * 1024;
+
+    constexpr size_t batch(size_t index){
+        return CACHE_BYTES / SizeClasses::size(index) < 8 ? 8 :
+               CACHE_BYTES / SizeClasses::size(index) > 128 ? 128 : CACHE_BYTES / SizeClasses::size(index);
+    }
+
+    // Shared part of a size class: a free list and the bump pointer carving fresh slots
+    struct SizeClass {
+        std::mutex lock;
+        void* free{nullptr};
+        char* top{nullptr};
+        char* committed{nullptr};
+        char* end{nullptr};
+    };
+
+    SizeClass sClasses[CLASS_COUNT];
+    char* sBase{nullptr};
+    std::atomic<bool> sReady{false};
+    pthread_once_t sOnce = PTHREAD_ONCE_INIT;
+    pthread_key_t sCacheKey;
+    size_t sSizes[CLASS_COUNT];
+    size_t sBatches[CLASS_COUNT];
+    // class of every size up to MAX_SIZE in steps of 8
+    unsigned char sClassOf[SizeClasses::MAX_SIZE / 8 + 1];
+
+    struct ThreadCache {
+        void* free[CLASS_COUNT];
+        size_t count[CLASS_COUNT];
+        bool registered;
+    };
+
+    __thread ThreadCache tCache __attribute__((tls_model("initial-exec")));
+
+    void** link(void* slot){ return static_cast<void**>(slot); }
+
+    void flush(size_t index, size_t count);
+    void flushAll(void*);
+
+    void lockAll(){ for(auto& sizeClass : sClasses){ sizeClass.lock.lock(); } }
+    void unlockAll(){ for(auto& sizeClass : sClasses){ sizeClass.lock.unlock(); } }
+
+    void initialize(){
+        sBase = static_cast<char*>(VirtualMemory::reserve(REGION_SIZE * CLASS_COUNT));
+        if(!sBase) return;
+        for(size_t i = 0; i < CLASS_COUNT; i++){
+            sSizes[i] = SizeClasses::size(i);
+            sBatches[i] = batch(i);
+            sClasses[i].top = sClasses[i].committed = sBase + i * REGION_SIZE;
+            sClasses[i].end = sBase + (i + 1) * REGION_SIZE;
+        }
+        // malloc promises alignof(max_align_t) for anything that can hold one, so requests of
+        // 16 bytes or more skip the classes whose slots would only be 8 byte aligned
+        for(size_t bytes = 0; bytes <= SizeClasses::MAX_SIZE; bytes += 8){
+            auto index = SizeClasses::index(bytes ? bytes : 1);
+            while(bytes >= DEFAULT_ALIGNMENT && sSizes[index] % DEFAULT_ALIGNMENT) ++index;
+            sClassOf[bytes / 8] = static_cast<unsigned char>(index);
+        }
+        pthread_key_create(&sCacheKey, flushAll);
+        sReady.store(true, std::memory_order_release);
+    }
+
+    bool ready(){
+        if(sReady.load(std::memory_order_acquire)) return true;
+        pthread_once(&sOnce, initialize);
+        return sReady.load(std::memory_order_acquire);
+    }
+
+    // pthread_atfork may allocate, so it is registered once the pools are up rather than from
+    // initialize(). The child of a fork must not inherit a lock held by another thread.
+    __attribute__((constructor)) void installForkHandlers(){
+        if(ready()) pthread_atfork(lockAll, unlockAll, unlockAll);
+    }
+
+    size_t classOf(size_t bytes){ return sClassOf[(bytes + 7) / 8]; }
+
+    bool owns(const void* ptr){
+        return sBase && uintptr_t(ptr) - uintptr_t(sBase) < REGION_SIZE * CLASS_COUNT;
+    }
+
+    // the page map: regions are laid out in class order
+    size_t classOfPointer(const void* ptr){
+        return (static_cast<const char*>(ptr) - sBase) / REGION_SIZE;
+    }
+
+    // fill an empty thread cache from the shared list, carving fresh slots when it runs dry
+    bool refill(size_t index){
+        auto& sizeClass = sClasses[index];
+        auto size = sSizes[index];
+        auto wanted = sBatches[index];
+        void* head = nullptr;
+        size_t count = 0;
+        std::lock_guard<std::mutex> lock(sizeClass.lock);
+        while(count < wanted && sizeClass.free){
+            auto slot = sizeClass.free;
+            sizeClass.free = *link(slot);
+            *link(slot) = head;
+            head = slot;
+            ++count;
+        }
+        while(count < wanted){
+            if(sizeClass.top + size > sizeClass.committed){
+                auto commit = sizeClass.end - sizeClass.committed < ptrdiff_t(COMMIT_SIZE) ? size_t(sizeClass.end - sizeClass.committed) : COMMIT_SIZE;
+                if(!commit || !VirtualMemory::commit(sizeClass.committed, commit)) break;
+                sizeClass.committed += commit;
+            }
+            auto slot = sizeClass.top;
+            sizeClass.top += size;
+            *link(slot) = head;
+            head = slot;
+            ++count;
+        }
+        tCache.free[index] = head;
+        tCache.count[index] = count;
+        return count > 0;
+    }
+
+    // return count slots from the front of the thread cache to the shared list
+    void flush(size_t index, size_t count){
+        auto first = tCache.free[index];
+        auto last = first;
+        for(size_t i = 1; i < count; i++){
+            last = *link(last);
+        }
+        tCache.free[index] = *link(last);
+        tCache.count[index] -= count;
+        auto& sizeClass = sClasses[index];
+        std::lock_guard<std::mutex> lock(sizeClass.lock);
+        *link(last) = sizeClass.free;
+        sizeClass.free = first;
+    }
+
+    // thread exit, later destructors that allocate register the cache again
+    void flushAll(void*){
+        for(size_t i = 0; i < CLASS_COUNT; i++){
+            if(tCache.count[i]) flush(i, tCache.count[i]);
+        }
+        tCache.registered = false;
+    }
+
+    // a thread that only frees fills its cache too, so both paths make sure it is flushed at exit
+    void ensureCache(){
+        if(!tCache.registered){
+            // the value only has to be non null for the destructor to run
+            tCache.registered = true;
+            pthread_setspecific(sCacheKey, &tCache);
+        }
+    }
+
+    void* poolAllocate(size_t index){
+        if(!tCache.free[index]){
+            ensureCache();
+            if(!refill(index)) return nullptr;
+        }
+        auto slot = tCache.free[index];
+        tCache.free[index] = *link(slot);
+        --tCache.count[index];
+        return slot;
+    }
+
+    void poolDeallocate(void* ptr){
+        auto index = classOfPointer(ptr);
+        ensureCache();
+        *link(ptr) = tCache.free[index];
+        tCache.free[index] = ptr;
+        if(++tCache.count[index] > 2 * sBatches[index]){
+            flush(index, sBatches[index]);
+        }
+    }
+
+    // smallest class whose slots are all aligned to alignment, CLASS_COUNT when there is none
+    size_t alignedClassOf(size_t bytes, size_t alignment){
+        if(bytes > SizeClasses::MAX_SIZE) return CLASS_COUNT;
+        for(size_t index = classOf(bytes); index < CLASS_COUNT; index++){
+            if((sSizes[index] & (alignment - 1)) == 0) return index;
+        }
+        return CLASS_COUNT;
+    }
+
+    void* alignedAllocate(size_t alignment, size_t bytes){
+        if(ready() && alignment <= SizeClasses::MAX_SIZE){
+            auto index = alignedClassOf(bytes, alignment);
+            if(index < CLASS_COUNT){
+                if(auto ptr = poolAllocate(index)) return ptr;
+            }
+        }
+        return __libc_memalign(alignment, bytes);
+    }
+
+    bool isPowerOfTwo(size_t value){ return value && !(value & (value - 1)); }
+}
+
+extern "C" {
+
+void* malloc(size_t bytes) noexcept {
+    if(bytes <= SizeClasses::MAX_SIZE && ready()){
+        if(auto ptr = poolAllocate(classOf(bytes))) return ptr;
+    }
+    return __libc_malloc(bytes);
+}
+
+void free(void* ptr) noexcept {
+    if(!ptr) return;
+    if(owns(ptr)){
+        poolDeallocate(ptr);
+    }else{
+        __libc_free(ptr);
+    }
+}
+
+void* calloc(size_t count, size_t bytes) noexcept {
+    size_t total;
+    if(__builtin_mul_overflow(count, bytes, &total)){
+        errno = ENOMEM;
+        return nullptr;
+    }
+    if(total <= SizeClasses::MAX_SIZE && ready()){
+        if(auto ptr = poolAllocate(classOf(total))){
+            memset(ptr, 0, total);
+            return ptr;
+        }
+    }
+    return __libc_calloc(count, bytes);
+}
+
+void* realloc(void* ptr, size_t bytes) noexcept {
+    if(!ptr) return malloc(bytes);
+    if(!bytes){
+        free(ptr);
+        return nullptr;
+    }
+    // moving a glibc block into the pools would need its size, it stays with glibc
+    if(!owns(ptr)) return __libc_realloc(ptr, bytes);
+    auto size = sSizes[classOfPointer(ptr)];
+    // shrinking within the class, or by less than half, keeps the slot
+    if(bytes <= size && bytes > size / 2) return ptr;
+    auto moved = malloc(bytes);
+    if(!moved) return nullptr;
+    memcpy(moved, ptr, bytes < size ? bytes : size);
+    poolDeallocate(ptr);
+    return moved;
+}
+
+int posix_memalign(void** result, size_t alignment, size_t bytes) noexcept {
+    if(!isPowerOfTwo(alignment) || alignment % sizeof(void*)) return EINVAL;
+    auto ptr = alignedAllocate(alignment, bytes);
+    if(!ptr) return ENOMEM;
+    *result = ptr;
+    return 0;
+}
+
+void* aligned_alloc(size_t alignment, size_t bytes) noexcept {
+    if(!isPowerOfTwo(alignment)){
+        errno = EINVAL;
+        return nullptr;
+    }
+    return alignedAllocate(alignment, bytes);
+}
+
+// glibc rounds an alignment that is not a power of two up to the next one
+void* memalign(size_t alignment, size_t bytes) noexcept {
+    if(alignment <= 1) return malloc(bytes);
+    return alignedAllocate(isPowerOfTwo(alignment) ? alignment : size_t(1) << (64 - __builtin_clzl(alignment)), bytes);
+}
+
+void* valloc(size_t bytes) noexcept {
+    return __libc_memalign(VirtualMemory::pageSize(), bytes);
+}
+
+void* pvalloc(size_t bytes) noexcept {
+    return __libc_memalign(VirtualMemory::pageSize(), VirtualMemory::roundToPages(bytes ? bytes : 1));
+}
+
+}
+
+// glibc has no exported usable size for its own blocks, so ask the next definition in the chain
+extern "C" size_t malloc_usable_size(void* ptr) noexcept {
+    if(!ptr) return 0;
+    if(owns(ptr)) return sSizes[classOfPointer(ptr)];
+    typedef size_t (*usable_size_function)(void*);
+    static usable_size_function sNext = reinterpret_cast<usable_size_function>(dlsym(RTLD_NEXT, "malloc_usable_size"));
+    return sNext ? sNext(ptr) : 0;
+}
+
+// Global operator new and delete, routed through the functions above
+
+namespace {
+    void* newOrThrow(size_t bytes){
+        for(;;){
+            if(auto ptr = malloc(bytes ? bytes : 1)) return ptr;
+            auto handler = std::get_new_handler();
+            if(!handler) throw std::bad_alloc();
+            handler();
+        }
+    }
+
+    void* alignedNewOrThrow(size_t bytes, std::align_val_t alignment){
+        for(;;){
+            if(auto ptr = alignedAllocate(static_cast<size_t>(alignment), bytes ? bytes : 1)) return ptr;
+            auto handler = std::get_new_handler();
+            if(!handler) throw std::bad_alloc();
+            handler();
+        }
+    }
+}
+
+void* operator new(size_t bytes){ return newOrThrow(bytes); }
+void* operator new[](size_t bytes){ return newOrThrow(bytes); }
+void* operator new(size_t bytes, const std::nothrow_t&) noexcept { return malloc(bytes ? bytes : 1); }
+void* operator new[](size_t bytes, const std::nothrow_t&) noexcept { return malloc(bytes ? bytes : 1); }
+void* operator new(size_t bytes, std::align_val_t alignment){ return alignedNewOrThrow(bytes, alignment); }
+void* operator new[](size_t bytes, std::align_val_t alignment){ return alignedNewOrThrow(bytes, alignment); }
+void* operator new(size_t bytes, std::align_val_t alignment, const std::nothrow_t&) noexcept { return alignedAllocate(static_cast<size_t>(alignment), bytes ? bytes : 1); }
+void* operator new[](size_t bytes, std::align_val_t alignment, const std::nothrow_t&) noexcept { return alignedAllocate(static_cast<size_t>(alignment), bytes ? bytes : 1); }
+
+void operator delete(void* ptr) noexcept { free(ptr); }
+void operator delete[](void* ptr) noexcept { free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { free(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { free(ptr); }
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { free(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { free(ptr); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { free(ptr); }
@@ -0,0 +1,118 @@
+//
+//  MallocAlignment.cpp
+//  MemoryManagement
+//
+
+// Checks the alignment malloc, calloc, realloc and operator new promise for every size the
+// pools serve and a little beyond, and that pooled pointers find their class from any thread.
+// Run it with LD_PRELOAD=libpoolmalloc.so, the malloc_alignment test does. It refuses to pass
+// when the pools are not the ones serving malloc. Exits non zero on the first failed check.
+
+#include <malloc.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    // alignment a block of bytes must have, the strictest fundamental alignment it can hold
+    size_t required(size_t bytes){
+        size_t alignment = alignof(max_align_t);
+        while(alignment > 1 && alignment > bytes) alignment /= 2;
+        return alignment;
+    }
+
+    bool check(const char* function, size_t bytes, void* ptr){
+        if(!ptr || uintptr_t(ptr) % required(bytes) == 0) return true;
+        fprintf(stderr, "%s(%zu) returned %p, not aligned to %zu\n", function, bytes, ptr, required(bytes));
+        return false;
+    }
+
+    bool expect(bool condition, const char* what){
+        if(!condition) fprintf(stderr, "%s\n", what);
+        return condition;
+    }
+
+    // glibc rounds 24 bytes to 24 usable, the pools skip the 24 byte class for 16 byte alignment
+    bool pooled(){
+        auto probe = malloc(24);
+        auto usable = malloc_usable_size(probe);
+        free(probe);
+        return usable == 32;
+    }
+
+    bool alignment(){
+        const size_t maxSize = 2048;
+        bool aligned = true;
+        std::vector<void*> blocks;
+        for(size_t bytes = 1; bytes <= maxSize; bytes++){
+            // a few of each size so the check sees more than the first slot of a class
+            for(int i = 0; i < 4; i++){
+                auto ptr = malloc(bytes);
+                aligned &= check("malloc", bytes, ptr);
+                blocks.push_back(ptr);
+                ptr = calloc(1, bytes);
+                aligned &= check("calloc", bytes, ptr);
+                blocks.push_back(ptr);
+                ptr = ::operator new(bytes);
+                aligned &= check("operator new", bytes, ptr);
+                ::operator delete(ptr);
+            }
+            auto grown = realloc(nullptr, 1);
+            grown = realloc(grown, bytes);
+            aligned &= check("realloc", bytes, grown);
+            free(grown);
+        }
+        for(auto ptr : blocks){ free(ptr); }
+        return aligned;
+    }
+
+    // blocks allocated on one thread are freed or grown on another, each must land back in its
+    // own class with its contents intact
+    bool crossThread(){
+        const size_t count = 4096;
+        std::vector<unsigned char*> blocks;
+        for(size_t i = 0; i < count; i++){
+            auto bytes = 1 + i % 1024;
+            blocks.push_back(static_cast<unsigned char*>(malloc(bytes)));
+            memset(blocks.back(), int(i & 0xFF), bytes);
+        }
+        bool intact = true;
+        std::thread([&]{
+            for(size_t i = 0; i < count; i++){
+                auto bytes = 1 + i % 1024;
+                if(i % 2){
+                    free(blocks[i]);
+                    blocks[i] = nullptr;
+                    continue;
+                }
+                auto grown = static_cast<unsigned char*>(realloc(blocks[i], bytes * 2 + 8));
+                for(size_t b = 0; b < bytes; b++){
+                    if(grown[b] != (i & 0xFF)){ intact = false; break; }
+                }
+                blocks[i] = grown;
+            }
+        }).join();
+        // the slots freed over there are served again here, once more from every class
+        for(size_t i = 1; i < count; i += 2){
+            auto bytes = 1 + i % 1024;
+            blocks[i] = static_cast<unsigned char*>(malloc(bytes));
+            intact &= blocks[i] != nullptr && malloc_usable_size(blocks[i]) >= bytes;
+        }
+        for(auto block : blocks){ free(block); }
+        return intact;
+    }
+}
+
+int main(){
+    bool passed = expect(pooled(), "malloc is not served by the pools, is LD_PRELOAD set?");
+    passed = passed && expect(alignment(), "misaligned sizes found");
+    passed = passed && expect(crossThread(), "cross thread free or realloc lost data");
+    printf("%s\n", passed ? "all checks passed" : "checks failed");
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,49 @@
+//
+//  HugePagePolicy.hpp
+//  ObjectPooling
+//
+
+#pragma once
+#include <cstddef>
+#include <new>
+#include "AllocatorTraits.hpp"
+#include "HugePages.hpp"
+
+// Allocation policy mapping every allocation on 2 MiB pages, meant for the large dense
+// arrays of a SparseSet. Use HugePageBlocks::report() to see which path backed them.
+template<typename T>
+class huge_page_policy
+{
+public:
+	
+	ALLOCATOR_TRAITS(T)
+	
+	template<typename U>
+	struct rebind
+	{
+		typedef huge_page_policy<U> other;
+	};
+	
+	// Default Constructor
+	huge_page_policy(void) = default;
+	
+	// Copy Constructor
+	template<typename U>
+	huge_page_policy(huge_page_policy<U> const& other){}
+	
+	// Allocate memory
+	pointer allocate(size_type count, const_pointer hint = 0)
+	{
+		if(count > max_size()){throw std::bad_alloc();}
+		return static_cast<pointer>(HugePageBlocks::allocate(count * sizeof(type), alignof(type)));
+	}
+	
+	// Delete memory
+	void deallocate(pointer ptr, size_type count)
+	{
+		HugePageBlocks::deallocate(ptr, count * sizeof(type), alignof(type));
+	}
+	
+	// Max number of objects that can be allocated in one call
+	size_type max_size(void) const {return max_allocations<T>::value;}
+};
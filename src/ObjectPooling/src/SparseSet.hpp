@@ -4,6 +4,8 @@
 #include "Allocator.hpp"
 #include "HeapPolicy.hpp"
 #include "ObjectTraits.hpp"
+#include "LatencySample.hpp"
+#include "Relocation.hpp"
 
 #define POOL_INDEX_BITS 16
 
@@ -39,7 +41,7 @@ struct Handle {
 
 	//explicit conversion
 	inline operator uint64_t() const {
-		return pool_id << (32+16) | slot_serial << 32 | slot_index;
+		return uint64_t(pool_id) << (32+16) | uint64_t(slot_serial) << 32 | slot_index;
 	}
 
 	inline bool isSet() {
@@ -59,15 +61,27 @@ public:
 	virtual ~IDeferredReclaimationMemoryPolicy() = default;
 };
 
-template<typename T>
+// DataPolicy allocates the dense data array, e.g. huge_page_policy for very large sets.
+// Only the first mBack data slots hold objects, freed ones among them are destroyed until
+// collect() relocates live objects from the back into them.
+template<typename T, typename DataPolicy = heap_policy<T>>
 class SparseSet : public IDeferredReclaimationMemoryPolicy {
 
+	using data_allocator = Allocator<T, DataPolicy, basic_object_traits<T>>;
+
 public:
 
-	using iterator = typename std::vector<T>::iterator;
-	using const_iterator = typename std::vector<T>::const_iterator;
+	using iterator = T*;
+	using const_iterator = const T*;
+
+	SparseSet() = default;
+	SparseSet(const SparseSet&) = delete;
+	SparseSet& operator=(const SparseSet&) = delete;
+
+	~SparseSet() { clear(); }
 
 	inline void collect() {
+		ALLOCATOR_LATENCY_SAMPLE(collectLatency());
 		//reclaim all memory
 
 		if (mUncollected == 0)
@@ -80,49 +94,33 @@ public:
 			return;
 		}
 
-		for (int i = 0; i < mBack; i++) {
-
-			auto & d = mDense[i];
+		//move the last live object into each hole, memcpy for trivially relocatable types
+		for (size_t i = 0; i < mBack; ) {
 
-			if (!d.alive) {
+			if (mDense[i].alive) {
+				++i;
+				continue;
+			}
 
-				auto last_dense = &mDense[mBack - 1];
-				while (!last_dense->alive) {
-					//need a live one to swap with.
-					--mBack;
-					last_dense = &mDense[mBack - 1];
+			auto last = mBack - 1;
+			if (last != i) {
+				if (mDense[last].alive) {
+					relocate(&mData[last], &mData[i]);
 				}
-
-				auto& cur_sparse = mSparse[d.sparse_slot_index];
-
-				auto& cur_data = mData[cur_sparse.dense_slot_index];
-				auto& last_alive_data = mData[mBack - 1];
-
-				//swap data
-				std::swap(std::move(cur_data), std::move(last_alive_data));
-
-				auto& other_sparse = mSparse[last_dense->sparse_slot_index];
-
-				//swap dense slot
-				std::swap(std::move(d), std::move(*last_dense));
-
-				//just swap sparse indices, not slot serial and alive is already set
-				auto tmp = cur_sparse.dense_slot_index;
-				cur_sparse.dense_slot_index = other_sparse.dense_slot_index;
-				other_sparse.dense_slot_index = tmp;
-
-				--mBack;
+				swapDense(i, last);
 			}
+			--mBack;
 		}
 		mUncollected = 0;
 	}
 
 	template<typename...Args>
 	inline Handle alloc(Args&&...args) {
+		ALLOCATOR_LATENCY_SAMPLE(allocLatency());
 
-		if (mBack >= mData.size()) {
+		if (mBack >= mCapacity) {
 			//grow as needed...slow if happens but dynamic
-			reserve(mData.size() + 1024);
+			reserve(mCapacity + 1024);
 		}
 
 		auto & next_data = mData[mBack];
@@ -139,7 +137,7 @@ public:
 		hndl.slot_serial = available_sparse.slot_serial;
 		mBack++;
 
-		new(&next_data) T(args...);
+		mAllocator.construct(&next_data, std::forward<Args>(args)...);
 
 		return std::move(hndl);
 	}
@@ -154,7 +152,7 @@ public:
 			mDense[s.dense_slot_index].alive = 0;
 			mUncollected++;
 
-			mData[s.dense_slot_index].~T();
+			mAllocator.destroy(&mData[s.dense_slot_index]);
 
 			return true;
 		}
@@ -178,40 +176,90 @@ public:
 	}
 
 	inline size_t size() const override { return mBack-mUncollected; }
-	inline size_t capacity() const { return mData.size(); }
+	inline size_t capacity() const { return mCapacity; }
 	inline bool needs_collection() const { return mUncollected > 0; }
 
-	inline iterator begin() { return mData.begin(); }
-	inline iterator end() { auto end = mData.begin(); std::advance(end, mBack); return end; }
+	inline iterator begin() { return mData; }
+	inline iterator end() { return mData + mBack; }
+
+	inline const_iterator cbegin() const { return mData; }
+	inline const_iterator cend() const { return mData + mBack; }
+
+#if defined(ALLOCATOR_LATENCY)
+	//sampled latencies
+	static LatencyRecorder& allocLatency() {
+		static LatencyRecorder sRecorder("SparseSet<" + std::to_string(sizeof(T)) + ">::alloc");
+		return sRecorder;
+	}
 
-	inline const_iterator cbegin() { return mData.cbegin(); }
-	inline const_iterator cend() { auto cend = mData.cbegin(); std::advance(cend, mBack); return cend; }
+	static LatencyRecorder& collectLatency() {
+		static LatencyRecorder sRecorder("SparseSet<" + std::to_string(sizeof(T)) + ">::collect", 1);
+		return sRecorder;
+	}
+#endif
 
+	//collects first so growth relocates live objects only, memcpy for trivially relocatable types
 	inline void reserve(size_t count)override {
-		mData.resize(count);
+		if (count <= mCapacity)
+			return;
+
+		collect();
+
+		auto data = mAllocator.allocate(count);
+		if (!data)
+			throw std::bad_alloc();
+		if (mData) {
+			relocate_n(mData, mBack, data);
+			mAllocator.deallocate(mData, mCapacity);
+		}
+
+		//new sparse and dense slots map to each other, existing mappings are kept
 		mSparse.resize(count);
 		mDense.resize(count);
-		for (int i = mBack; i < count; i++) {
+		for (size_t i = mCapacity; i < count; i++) {
 			mSparse[i].dense_slot_index = i;
-		}
-		for (int i = mBack; i < count; i++) {
 			mDense[i].sparse_slot_index = i;
 		}
+
+		mData = data;
+		mCapacity = count;
 	}
 
 	inline void clear() override {
-		mData.clear();
+		if (mUncollected == 0) {
+			mAllocator.destroy_n(mData, mBack);
+		}
+		else {
+			for (size_t i = 0; i < mBack; i++) {
+				if (mDense[i].alive)
+					mAllocator.destroy(&mData[i]);
+			}
+		}
+		if (mData)
+			mAllocator.deallocate(mData, mCapacity);
+		mData = nullptr;
+		mCapacity = 0;
 		mSparse.clear();
 		mDense.clear();
 		mBack = 0;
+		mUncollected = 0;
 	}
 
 private:
 
+	//swap two dense slots and point their sparse slots at the new positions
+	inline void swapDense(size_t a, size_t b) {
+		std::swap(mDense[a], mDense[b]);
+		mSparse[mDense[a].sparse_slot_index].dense_slot_index = a;
+		mSparse[mDense[b].sparse_slot_index].dense_slot_index = b;
+	}
+
 	size_t mBack{0};
 	size_t mUncollected{0};
+	size_t mCapacity{0};
 	std::vector<SparseSlotIndex> mSparse;
 	std::vector<DenseSlotIndex> mDense;
-	std::vector<T, Allocator<T, heap_policy<T>, basic_object_traits<T>>> mData;
+	data_allocator mAllocator;
+	T* mData{nullptr};
 
 };
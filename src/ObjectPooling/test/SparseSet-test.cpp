@@ -3,6 +3,7 @@
 #include "TestClass.h"
 #include "SparseSet.hpp"
 #include <iostream>
+#include <string>
 
 TEST_CASE( "Sparse Set", "[memory]" ) {
 
@@ -211,5 +212,44 @@ TEST_CASE( "Sparse Set", "[memory]" ) {
 
 	}
 
+}
 
-}
\ No newline at end of file
+TEST_CASE( "Sparse Set relocation", "[memory]" ) {
+
+	//std::string is not trivially relocatable, collect and growth move construct it
+	SparseSet<std::string> set;
+	std::vector<Handle> handles;
+	for (int i = 0; i < 3000; i++) {
+		handles.push_back(set.alloc(std::string(40, char('a' + i % 26))));
+	}
+	for (int i = 0; i < 3000; i += 3) {
+		REQUIRE(set.free(handles[i]));
+	}
+
+	set.collect();
+	REQUIRE(set.size() == 2000);
+	REQUIRE_FALSE(set.needs_collection());
+
+	//growth after the holes were filled keeps every handle pointing at its value
+	for (int i = 0; i < 2000; i++) {
+		handles.push_back(set.alloc(std::string(40, 'z')));
+	}
+	REQUIRE(set.capacity() >= 4000);
+	for (int i = 0; i < 3000; i++) {
+		auto value = set.get(handles[i]);
+		if (i % 3 == 0) {
+			REQUIRE_FALSE(value);
+		}
+		else {
+			REQUIRE(value);
+			REQUIRE(*value == std::string(40, char('a' + i % 26)));
+		}
+	}
+
+	size_t count = 0;
+	for (auto& value : set) {
+		REQUIRE(value.size() == 40);
+		count++;
+	}
+	REQUIRE(count == set.size());
+}
@@ -0,0 +1,83 @@
+//
+//  test-Alignment.cpp
+//  MemoryManagement
+//
+
+#include <vector>
+#include "catch.hpp"
+#include "Allocator.hpp"
+#include "FreeStoreAllocator.hpp"
+#include "MmapStorage.hpp"
+
+namespace {
+
+struct alignas(32) Lanes { float values[8]; };
+struct alignas(64) Wide { double values[3]; };
+struct Tally { uint64_t count; };
+
+bool aligned(const void* ptr, size_t alignment){
+    return reinterpret_cast<uintptr_t>(ptr) % alignment == 0;
+}
+
+}
+
+TEST_CASE("StorageSlotAlignment","[storage]"){
+
+    REQUIRE(BlockListStorage<24, 4096>::OBJECT_ALIGNMENT == 8);
+    REQUIRE(BlockListStorage<48, 4096>::OBJECT_ALIGNMENT == 16);
+    REQUIRE(FixedSizeStorage<64, 4096>::OBJECT_ALIGNMENT == 64);
+    REQUIRE(FixedSizeStorage<8192, 65536>::OBJECT_ALIGNMENT == 4096);
+
+    BlockListStorage<64, 1024> storage;
+    for(size_t i = 0; i < 1000; i++){
+        REQUIRE(aligned(storage[i], 64));
+    }
+}
+
+TEST_CASE("FreeStoreAllocatorAlignment","[allocator]"){
+
+    using LanesAlloc = Allocator<Lanes, FreeStoreAllocator<Lanes, BlockListStorage, 4096>>;
+    using WideAlloc = Allocator<Wide, FreeStoreAllocator<Wide, FixedSizeStorage, 65536>>;
+    using MmapAlloc = Allocator<Lanes, FreeStoreAllocator<Lanes, MmapStorage, 65536>>;
+    // cache line per counter, no two counters share a line
+    using PaddedAlloc = Allocator<Tally, FreeStoreAllocator<Tally, BlockListStorage, 4096, DefaultFreeStore, 64>>;
+
+    REQUIRE(PaddedAlloc::Policy::SLOT_SIZE == 64);
+
+    LanesAlloc lanes;
+    WideAlloc wide;
+    MmapAlloc mapped;
+    PaddedAlloc padded;
+    for(int i = 0; i < 500; i++){
+        REQUIRE(aligned(lanes.allocate(), 32));
+        REQUIRE(aligned(wide.allocate(), 64));
+        REQUIRE(aligned(mapped.allocate(), 32));
+        REQUIRE(aligned(padded.allocate(), 64));
+    }
+
+    // arrays go to the heap, which honors the same alignment
+    auto array = wide.allocate(7);
+    REQUIRE(aligned(array, 64));
+    wide.deallocate(array, 7);
+}
+
+TEST_CASE("HeapAllocatorAlignment","[allocator]"){
+
+    Allocator<Wide> wide;
+    Allocator<Tally, HeapAllocator<Tally, 128>> raised;
+    for(size_t count = 1; count < 20; count++){
+        auto first = wide.allocate(count);
+        auto second = raised.allocate(count);
+        REQUIRE(aligned(first, 64));
+        REQUIRE(aligned(second, 128));
+        wide.deallocate(first, count);
+        raised.deallocate(second, count);
+    }
+
+    std::vector<Wide, Allocator<Wide>> values(100);
+    REQUIRE(aligned(values.data(), 64));
+
+    auto block = Heap<24, 256>::get()->allocate(3);
+    REQUIRE(aligned(block, 256));
+    Heap<24, 256>::get()->deallocate(block);
+}
@@ -0,0 +1,112 @@
+//
+//  test-AllocationStatistics.cpp
+//  MemoryManagement
+//
+
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "catch.hpp"
+#include "Allocator.hpp"
+#include "FreeStoreAllocator.hpp"
+
+TEST_CASE("FreeStoreStatistics","[allocator]"){
+
+    struct Order { uint64_t id; double price; uint32_t quantity; };
+    using Alloc = Allocator<Order, FreeStoreAllocator<Order, BlockListStorage, 1024, CountedFreeStore>>;
+    using Storage = BlockListStorage<sizeof(Order), 1024>;
+
+    Alloc alloc;
+    std::vector<Order*> orders;
+    for(int i = 0; i < 100; i++){
+        orders.push_back(alloc.allocate());
+    }
+    for(int i = 0; i < 40; i++){
+        alloc.deallocate(orders.back());
+        orders.pop_back();
+    }
+
+    auto snapshot = alloc.statistics();
+    REQUIRE(snapshot.allocations == 100);
+    REQUIRE(snapshot.deallocations == 40);
+    REQUIRE(snapshot.live == 60);
+    REQUIRE(snapshot.high_water_mark == 100);
+    REQUIRE(snapshot.free_list_length == 40);
+    REQUIRE(snapshot.blocks_reserved == (100 + Storage::OBJECTS_PER_BLOCK - 1) / Storage::OBJECTS_PER_BLOCK);
+
+    // reuse does not move the high-water mark
+    Order* batch[10];
+    alloc.allocate_n(batch, 10);
+    snapshot = alloc.statistics();
+    REQUIRE(snapshot.allocations == 110);
+    REQUIRE(snapshot.live == 70);
+    REQUIRE(snapshot.high_water_mark == 100);
+    REQUIRE(snapshot.free_list_length == 30);
+
+    alloc.deallocate_n(batch, 10);
+    for(auto order : orders){ alloc.deallocate(order); }
+    REQUIRE(alloc.statistics().live == 0);
+}
+
+TEST_CASE("FreeStoreStatisticsFailedBatch","[allocator]"){
+
+    using Store = FreeStore<32, FixedSizeStorage<32, 32 * 100>, AllocationStatistics>;
+    Store store;
+
+    // half from the free list, half fresh, then the storage runs out part way through
+    std::vector<void*> held(60);
+    store.allocate_n(held.data(), held.size());
+    store.deallocate_n(held.data(), 30);
+    std::vector<void*> batch(80);
+    REQUIRE_THROWS_AS(store.allocate_n(batch.data(), batch.size()), std::bad_alloc);
+
+    // the failed batch counts as neither allocated nor freed and leaves its slots free
+    auto snapshot = store.statistics();
+    REQUIRE(snapshot.allocations == 60);
+    REQUIRE(snapshot.deallocations == 30);
+    REQUIRE(snapshot.live == 30);
+    REQUIRE(snapshot.free_list_length == 70);
+
+    std::vector<void*> rest(70);
+    store.allocate_n(rest.data(), rest.size());
+    store.deallocate_n(rest.data(), rest.size());
+    store.deallocate_n(held.data() + 30, 30);
+    snapshot = store.statistics();
+    REQUIRE(snapshot.allocations == snapshot.deallocations);
+    REQUIRE(snapshot.live == 0);
+    REQUIRE(snapshot.free_list_length == 100);
+}
+
+TEST_CASE("NoStatistics","[allocator]"){
+
+    REQUIRE(std::is_empty<NoStatistics>::value);
+
+    using Store = FreeStore<24, FixedSizeStorage<24, 24 * 16>, NoStatistics>;
+    // the disabled policy adds nothing to the store
+    REQUIRE(sizeof(Store) + sizeof(AllocationStatistics) == sizeof(FreeStore<24, FixedSizeStorage<24, 24 * 16>, AllocationStatistics>));
+    auto ptr = Store::get()->allocate();
+    auto snapshot = Store::get()->statistics();
+    REQUIRE(snapshot.allocations == 0);
+    REQUIRE(snapshot.live == 0);
+    REQUIRE(snapshot.high_water_mark == 1);
+    REQUIRE(snapshot.blocks_reserved == 1);
+    Store::get()->deallocate(ptr);
+}
+
+TEST_CASE("AllocationStatisticsThreads","[allocator]"){
+
+    AllocationStatistics statistics;
+    std::vector<std::thread> threads;
+    for(int t = 0; t < 8; t++){
+        threads.emplace_back([&statistics]{
+            for(int i = 0; i < 10000; i++){
+                statistics.onAllocate();
+                if(i % 2) statistics.onDeallocate();
+            }
+        });
+    }
+    for(auto& thread : threads){ thread.join(); }
+
+    REQUIRE(statistics.allocations() == 80000);
+    REQUIRE(statistics.deallocations() == 40000);
+}
@@ -0,0 +1,139 @@
+//
+//  test-AllocatorAwareContainers.cpp
+//  MemoryManagement
+//
+
+#include <deque>
+#include <forward_list>
+#include <list>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "catch.hpp"
+#include "Allocator.hpp"
+#include "ArenaAllocator.hpp"
+#include "FreeStoreAllocator.hpp"
+#include "FreeStorePool.hpp"
+#include "SizeClassAllocator.hpp"
+
+namespace {
+
+    template<typename T>
+    using PoolAlloc = Allocator<T, FreeStoreAllocator<T, BlockListStorage, 4096>>;
+
+    template<typename T>
+    using HeapAlloc = Allocator<T, HeapAllocator<T>>;
+
+    template<typename V> struct make { static V value(int i){ return V(i); } };
+    template<> struct make<char> { static char value(int i){ return char('a' + i % 26); } };
+    template<typename K, typename V> struct make<std::pair<K,V>> { static std::pair<K,V> value(int i){ return {i, i}; } };
+
+    template<typename Container>
+    void fill(Container& c, int count){
+        for(int i = 0; i < count; i++){
+            c.insert(c.end(), make<typename Container::value_type>::value(i));
+        }
+    }
+
+    template<typename T, typename A>
+    void fill(std::forward_list<T,A>& c, int count){
+        for(int i = 0; i < count; i++){
+            c.push_front(make<T>::value(i));
+        }
+    }
+
+    // Moves and swaps must hand the memory over, an element keeps its address throughout.
+    // first and second are unequal, the propagation traits carry the allocator along.
+    template<typename Container>
+    void checkAllocatorAware(typename Container::allocator_type const& first,
+                             typename Container::allocator_type const& second){
+        Container a(first);
+        fill(a, 100);
+        auto element = &*a.begin();
+
+        // move construction steals
+        Container b(std::move(a));
+        REQUIRE(&*b.begin() == element);
+        REQUIRE(b.get_allocator() == first);
+
+        // move assignment between pools steals and takes the allocator
+        Container c(second);
+        fill(c, 10);
+        c = std::move(b);
+        REQUIRE(&*c.begin() == element);
+        REQUIRE(c.get_allocator() == first);
+
+        // swap exchanges the allocators with the contents, both long enough to be on the heap
+        Container d(second);
+        fill(d, 100);
+        auto other = &*d.begin();
+        c.swap(d);
+        REQUIRE(&*d.begin() == element);
+        REQUIRE(&*c.begin() == other);
+        REQUIRE(d.get_allocator() == first);
+        REQUIRE(c.get_allocator() == second);
+
+        // copy assignment copies the elements and the allocator
+        Container e(second);
+        e = d;
+        REQUIRE(e.get_allocator() == first);
+        REQUIRE(std::equal(e.begin(), e.end(), d.begin()));
+    }
+
+    template<template<typename> class Alloc>
+    void checkEveryContainer(Alloc<int> const& first, Alloc<int> const& second){
+        typedef std::pair<const int, int> Entry;
+        checkAllocatorAware<std::vector<int, Alloc<int>>>(first, second);
+        checkAllocatorAware<std::deque<int, Alloc<int>>>(first, second);
+        checkAllocatorAware<std::list<int, Alloc<int>>>(first, second);
+        checkAllocatorAware<std::forward_list<int, Alloc<int>>>(first, second);
+        checkAllocatorAware<std::set<int, std::less<int>, Alloc<int>>>(first, second);
+        checkAllocatorAware<std::multiset<int, std::less<int>, Alloc<int>>>(first, second);
+        checkAllocatorAware<std::map<int, int, std::less<int>, Alloc<Entry>>>(first, second);
+        checkAllocatorAware<std::multimap<int, int, std::less<int>, Alloc<Entry>>>(first, second);
+        checkAllocatorAware<std::unordered_set<int, std::hash<int>, std::equal_to<int>, Alloc<int>>>(first, second);
+        checkAllocatorAware<std::unordered_multiset<int, std::hash<int>, std::equal_to<int>, Alloc<int>>>(first, second);
+        checkAllocatorAware<std::unordered_map<int, int, std::hash<int>, std::equal_to<int>, Alloc<Entry>>>(first, second);
+        checkAllocatorAware<std::unordered_multimap<int, int, std::hash<int>, std::equal_to<int>, Alloc<Entry>>>(first, second);
+        checkAllocatorAware<std::basic_string<char, std::char_traits<char>, Alloc<char>>>(first, second);
+    }
+}
+
+TEST_CASE("AllocatorEquality","[allocator]"){
+
+    FreeStorePool first, second;
+    REQUIRE(PoolAlloc<int>(first) == PoolAlloc<int>(first));
+    REQUIRE(PoolAlloc<int>(first) != PoolAlloc<int>(second));
+    REQUIRE(PoolAlloc<int>() == PoolAlloc<int>());
+    // rebound copies compare equal to their source
+    REQUIRE(PoolAlloc<double>(PoolAlloc<int>(first)) == PoolAlloc<int>(first));
+
+    REQUIRE(HeapAlloc<int>() == HeapAlloc<double>());
+    REQUIRE(Allocator<int, SizeClassAllocator<int>>() == Allocator<int, SizeClassAllocator<int>>());
+
+    Arena arena, other;
+    REQUIRE(Allocator<int, ArenaAllocator<int>>(arena) == Allocator<char, ArenaAllocator<char>>(arena));
+    REQUIRE(Allocator<int, ArenaAllocator<int>>(arena) != Allocator<int, ArenaAllocator<int>>(other));
+
+    // different policies never free each other's memory
+    REQUIRE(HeapAlloc<int>() != PoolAlloc<int>());
+
+    REQUIRE(std::allocator_traits<HeapAlloc<int>>::is_always_equal::value);
+    REQUIRE_FALSE(std::allocator_traits<PoolAlloc<int>>::is_always_equal::value);
+    REQUIRE(std::allocator_traits<PoolAlloc<int>>::propagate_on_container_move_assignment::value);
+    REQUIRE(std::allocator_traits<PoolAlloc<int>>::propagate_on_container_swap::value);
+}
+
+TEST_CASE("AllocatorAwarePoolContainers","[allocator]"){
+
+    FreeStorePool first, second;
+    checkEveryContainer<PoolAlloc>(PoolAlloc<int>(first), PoolAlloc<int>(second));
+}
+
+TEST_CASE("AllocatorAwareHeapContainers","[allocator]"){
+
+    checkEveryContainer<HeapAlloc>(HeapAlloc<int>(), HeapAlloc<int>());
+}
@@ -0,0 +1,111 @@
+//
+//  test-ArenaAllocator.cpp
+//  MemoryManagement
+//
+
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <vector>
+#include "catch.hpp"
+#include "Allocator.hpp"
+#include "ArenaAllocator.hpp"
+
+TEST_CASE("ArenaMarkRewind","[arena]"){
+
+    Arena arena(1024);
+    REQUIRE(arena.used() == 0);
+
+    auto first = static_cast<char*>(arena.allocate(100));
+    auto second = static_cast<char*>(arena.allocate(8, 8));
+    REQUIRE(second >= first + 100);
+    REQUIRE(reinterpret_cast<uintptr_t>(second) % 8 == 0);
+
+    auto marker = arena.mark();
+    auto used = arena.used();
+
+    // spill over several chunks, including one larger than the chunk size
+    for(int i = 0; i < 50; i++){
+        arena.allocate(100);
+    }
+    auto big = arena.allocate(4096, 64);
+    REQUIRE(reinterpret_cast<uintptr_t>(big) % 64 == 0);
+    auto reserved = arena.reserved();
+    REQUIRE(reserved > 4096);
+    auto highWater = arena.high_water_mark();
+
+    arena.rewind(marker);
+    REQUIRE(arena.used() == used);
+    REQUIRE(arena.allocate(8, 8) == second + 8);
+
+    // chunks are reused, nothing new is reserved for the same work
+    for(int i = 0; i < 50; i++){
+        arena.allocate(100);
+    }
+    arena.allocate(4096, 64);
+    REQUIRE(arena.reserved() == reserved);
+
+    arena.release_all();
+    REQUIRE(arena.used() == 0);
+    REQUIRE(arena.allocate(100) == first);
+    REQUIRE(arena.high_water_mark() >= highWater);
+}
+
+TEST_CASE("ArenaAllocatorContainers","[arena]"){
+
+    Arena arena;
+    {
+        using IntAlloc = Allocator<int, ArenaAllocator<int>>;
+        using PairAlloc = Allocator<std::pair<const int, double>, ArenaAllocator<std::pair<const int, double>>>;
+
+        std::vector<int, IntAlloc> values{IntAlloc(arena)};
+        std::map<int, double, std::less<int>, PairAlloc> lookup{std::less<int>(), PairAlloc(arena)};
+        for(int i = 0; i < 1000; i++){
+            values.push_back(i);
+            lookup[i] = i * 0.5;
+        }
+        REQUIRE(values.size() == 1000);
+        REQUIRE(values[999] == 999);
+        REQUIRE(lookup[500] == 250.0);
+        REQUIRE(lookup.get_allocator().arena() == &arena);
+    }
+    REQUIRE(arena.used() > 1000 * sizeof(int));
+    arena.release_all();
+    REQUIRE(arena.used() == 0);
+}
+
+TEST_CASE("ArenaAllocatorRequests","[.][benchmark]"){
+
+    const int requests = 20000;
+    const int entries = 64;
+
+    auto start = std::chrono::steady_clock::now();
+    for(int r = 0; r < requests; r++){
+        std::vector<int> values;
+        std::map<int, int> lookup;
+        for(int i = 0; i < entries; i++){
+            values.push_back(i);
+            lookup[i] = i;
+        }
+    }
+    auto heap = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    Arena arena;
+    using IntAlloc = Allocator<int, ArenaAllocator<int>>;
+    using PairAlloc = Allocator<std::pair<const int, int>, ArenaAllocator<std::pair<const int, int>>>;
+    start = std::chrono::steady_clock::now();
+    for(int r = 0; r < requests; r++){
+        {
+            std::vector<int, IntAlloc> values{IntAlloc(arena)};
+            std::map<int, int, std::less<int>, PairAlloc> lookup{std::less<int>(), PairAlloc(arena)};
+            for(int i = 0; i < entries; i++){
+                values.push_back(i);
+                lookup[i] = i;
+            }
+        }
+        arena.release_all();
+    }
+    auto arenaTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "heap: " << heap * 1e3 << "ms arena: " << arenaTime * 1e3 << "ms" << std::endl;
+}
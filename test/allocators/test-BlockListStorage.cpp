@@ -0,0 +1,69 @@
+//
+//  test-BlockListStorage.cpp
+//  MemoryManagement
+//
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <set>
+#include <vector>
+#include "catch.hpp"
+#include "FreeStore.hpp"
+
+TEST_CASE("BlockListStorageDirectory","[storage]"){
+
+    using Storage = BlockListStorage<24, 1000>;
+
+    REQUIRE(Storage::OBJECT_SIZE == 24);
+    REQUIRE(Storage::OBJECTS_PER_BLOCK == 32);
+    REQUIRE((size_t(1) << Storage::BLOCK_SHIFT) == Storage::OBJECTS_PER_BLOCK);
+
+    Storage storage;
+    REQUIRE(storage.capacity() == Storage::OBJECTS_PER_BLOCK);
+
+    auto first = storage[0];
+    auto lastOfFirstBlock = storage[Storage::OBJECTS_PER_BLOCK - 1];
+    REQUIRE(static_cast<char*>(lastOfFirstBlock) - static_cast<char*>(first) == (Storage::OBJECTS_PER_BLOCK - 1) * Storage::OBJECT_SIZE);
+
+    // jumping ahead creates every block in between
+    std::vector<void*> addresses;
+    const size_t count = Storage::OBJECTS_PER_BLOCK * 100;
+    for(size_t i = 0; i < count; i++){
+        addresses.push_back(storage[i]);
+    }
+    REQUIRE(storage.capacity() == count);
+    REQUIRE(std::set<void*>(addresses.begin(), addresses.end()).size() == count);
+
+    // growing the directory never relocates existing blocks
+    storage[count * 10];
+    REQUIRE(storage.capacity() == count * 10 + Storage::OBJECTS_PER_BLOCK);
+    REQUIRE(storage[0] == first);
+    for(size_t i = 0; i < count; i++){
+        REQUIRE(storage[i] == addresses[i]);
+    }
+}
+
+TEST_CASE("BlockListStorageLookup","[.][benchmark]"){
+
+    using Storage = BlockListStorage<8, 64>;
+    const size_t lookups = 1000000;
+
+    for(size_t blocks = 1; blocks <= 100000; blocks *= 10){
+        Storage storage;
+        const size_t objects = blocks * Storage::OBJECTS_PER_BLOCK;
+        storage[objects - 1];
+
+        std::mt19937 rng(blocks);
+        std::vector<size_t> indices(lookups);
+        for(auto& index : indices){ index = rng() % objects; }
+
+        uintptr_t sink = 0;
+        auto start = std::chrono::steady_clock::now();
+        for(auto index : indices){
+            sink += reinterpret_cast<uintptr_t>(storage[index]);
+        }
+        auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        std::cout << blocks << " blocks: " << elapsed / lookups << " ns/lookup (" << (sink & 1) << ")" << std::endl;
+    }
+}
@@ -0,0 +1,133 @@
+//
+//  test-BuddyAllocator.cpp
+//  MemoryManagement
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "catch.hpp"
+#include "Allocator.hpp"
+#include "BuddyAllocator.hpp"
+#include "Heap.hpp"
+
+TEST_CASE("BuddyStoreSplitMerge","[buddy]"){
+
+    using Store = BuddyStore<1024, 1024 * 1024>;
+    auto store = Store::get();
+    REQUIRE(Store::MAX_ORDER == 10);
+    REQUIRE(Store::block_size(1) == 1024);
+    REQUIRE(Store::block_size(1025) == 2048);
+    REQUIRE(Store::block_size(4096) == 4096);
+
+    auto small = store->allocate(1000);
+    auto medium = store->allocate(3000);
+    auto large = store->allocate(100000);
+    REQUIRE(reinterpret_cast<uintptr_t>(medium) % 4096 == 0);
+    REQUIRE(store->capacity() == 1024 * 1024 - 1024 - 4096 - 131072);
+
+    auto report = store->report();
+    REQUIRE(report.allocatedBytes == 1024 + 4096 + 131072);
+    REQUIRE(report.freeBytes + report.allocatedBytes == 1024 * 1024);
+    REQUIRE(report.largestFreeBlock == 512 * 1024);
+    REQUIRE(report.fragmentation > 0.0);
+
+    store->deallocate(nullptr);
+    REQUIRE(store->capacity() == 1024 * 1024 - 1024 - 4096 - 131072);
+
+    store->deallocate(medium);
+    store->deallocate(small);
+    store->deallocate(large);
+
+    // everything coalesces back into the single top block
+    report = store->report();
+    REQUIRE(report.freeBlocks[Store::MAX_ORDER] == 1);
+    REQUIRE(report.freeBytes == 1024 * 1024);
+    REQUIRE(report.fragmentation == 0.0);
+
+    auto whole = store->allocate(1024 * 1024);
+    REQUIRE_THROWS_AS(store->allocate(1), std::bad_alloc);
+    store->deallocate(whole);
+}
+
+TEST_CASE("BuddyStoreRandom","[buddy]"){
+
+    using Store = BuddyStore<1024, 16 * 1024 * 1024>;
+    auto store = Store::get();
+    std::mt19937 random(7);
+    std::uniform_int_distribution<size_t> sizes(1, 16 * 1024);
+
+    struct Block { unsigned char* ptr; size_t size; unsigned char fill; };
+    std::vector<Block> blocks;
+    for(int round = 0; round < 2000; round++){
+        if(blocks.empty() || random() % 2 == 0){
+            auto size = sizes(random);
+            auto fill = static_cast<unsigned char>(round);
+            auto ptr = static_cast<unsigned char*>(store->allocate(size));
+            std::memset(ptr, fill, size);
+            blocks.push_back(Block{ptr, size, fill});
+        }else{
+            std::swap(blocks[random() % blocks.size()], blocks.back());
+            auto& block = blocks.back();
+            // nothing else wrote over this block
+            REQUIRE(block.ptr[0] == block.fill);
+            REQUIRE(block.ptr[block.size - 1] == block.fill);
+            store->deallocate(block.ptr);
+            blocks.pop_back();
+        }
+    }
+    std::shuffle(blocks.begin(), blocks.end(), random);
+    for(auto& block : blocks){
+        REQUIRE(block.ptr[block.size / 2] == block.fill);
+        store->deallocate(block.ptr);
+    }
+    REQUIRE(store->report().freeBlocks[Store::MAX_ORDER] == 1);
+}
+
+TEST_CASE("BuddyAllocatorVector","[buddy]"){
+
+    using ByteAlloc = Allocator<char, BuddyAllocator<char>>;
+    std::vector<char, ByteAlloc> buffer;
+    for(int i = 0; i < 3 * 1024 * 1024; i++){
+        buffer.push_back(static_cast<char>(i));
+    }
+    REQUIRE(buffer[12345] == static_cast<char>(12345));
+    REQUIRE(ByteAlloc().report().allocatedBytes == 4 * 1024 * 1024);
+}
+
+TEST_CASE("BuddyAllocatorMixedSizes","[.][benchmark]"){
+
+    const size_t operations = 200000;
+    const size_t live = 256;
+    std::mt19937 random(11);
+    // mostly small buffers with an occasional multi megabyte one
+    std::vector<size_t> sizes(operations);
+    for(auto& size : sizes){
+        size = random() % 16 ? 1024 + random() % (64 * 1024) : 1024 * 1024 + random() % (3 * 1024 * 1024);
+    }
+    std::vector<size_t> victims(operations);
+    for(auto& victim : victims){ victim = random() % live; }
+
+    auto run = [&](const char* label, IAllocator* allocator){
+        std::vector<void*> slots(live, nullptr);
+        auto start = std::chrono::steady_clock::now();
+        for(size_t i = 0; i < operations; i++){
+            auto& slot = slots[victims[i]];
+            if(slot) allocator->deallocate(slot);
+            slot = allocator->allocate(sizes[i]);
+            static_cast<char*>(slot)[0] = 1;
+        }
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        for(auto slot : slots){ if(slot) allocator->deallocate(slot); }
+        std::cout << label << ": " << operations / elapsed / 1e6 << " Mops/s" << std::endl;
+    };
+
+    run("Heap<1>", Heap<1>::get());
+    auto buddy = BuddyStore<1024, size_t(1) << 30>::get();
+    run("BuddyStore", buddy);
+    auto report = buddy->report();
+    std::cout << "fragmentation after run: " << report.fragmentation << std::endl;
+}
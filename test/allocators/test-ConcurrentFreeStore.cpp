@@ -0,0 +1,123 @@
+//
+//  test-ConcurrentFreeStore.cpp
+//  MemoryManagement
+//
+
+#include <atomic>
+#include <mutex>
+#include <random>
+#include <set>
+#include <thread>
+#include <vector>
+#include "catch.hpp"
+#include "ConcurrentFreeStore.hpp"
+
+// the first word is the free list link, the second marks who currently owns the slot
+struct Slot {
+    void* link;
+    std::atomic<uint64_t> owner;
+    uint64_t pad[2];
+};
+
+TEST_CASE("ConcurrentFreeStoreStress","[allocator]"){
+
+    using Storage = FixedSizeStorage<sizeof(Slot), sizeof(Slot) * 4096>;
+    using Store = ConcurrentFreeStore<sizeof(Slot), Storage>;
+
+    const size_t numThreads = 8;
+    const size_t iterations = 20000;
+
+    std::atomic<size_t> doubleHandout{0};
+    std::atomic<size_t> badRelease{0};
+    std::mutex mailboxMutex;
+    std::vector<std::pair<Slot*, uint64_t>> mailbox;
+
+    auto acquire = [&](uint64_t id){
+        auto slot = static_cast<Slot*>(Store::get()->allocate());
+        if(slot->owner.exchange(id) != 0) doubleHandout++;
+        return slot;
+    };
+    auto release = [&](Slot* slot, uint64_t id){
+        if(slot->owner.exchange(0) != id) badRelease++;
+        Store::get()->deallocate(slot);
+    };
+
+    std::vector<std::thread> threads;
+    for(uint64_t t = 1; t <= numThreads; t++){
+        threads.emplace_back([&, t]{
+            std::mt19937 rng(t);
+            std::vector<Slot*> batch;
+            std::vector<std::pair<Slot*, uint64_t>> received;
+            for(size_t i = 0; i < iterations; i++){
+                auto count = 1 + rng() % 16;
+                for(size_t j = 0; j < count; j++){
+                    batch.push_back(acquire(t));
+                }
+                // hand half of the batches to whichever thread frees next, the lock only
+                // guards the mailbox so frees race each other and the allocations
+                bool posted = false;
+                {
+                    std::lock_guard<std::mutex> lock(mailboxMutex);
+                    if(rng() % 2 && mailbox.size() < 256){
+                        for(auto slot : batch) mailbox.emplace_back(slot, t);
+                        posted = true;
+                    }else{
+                        while(!mailbox.empty() && rng() % 4){
+                            received.push_back(mailbox.back());
+                            mailbox.pop_back();
+                        }
+                    }
+                }
+                if(!posted){
+                    for(auto slot : batch) release(slot, t);
+                }
+                for(auto& entry : received) release(entry.first, entry.second);
+                received.clear();
+                batch.clear();
+            }
+        });
+    }
+    for(auto& thread : threads){ thread.join(); }
+    for(auto& entry : mailbox){ release(entry.first, entry.second); }
+
+    REQUIRE(doubleHandout == 0);
+    REQUIRE(badRelease == 0);
+
+    // every slot is back on the free list exactly once
+    std::set<void*> unique;
+    for(size_t i = 0; i < Storage::OBJECTS_PER_BLOCK; i++){
+        unique.insert(Store::get()->allocate());
+    }
+    REQUIRE(unique.size() == Storage::OBJECTS_PER_BLOCK);
+    REQUIRE_THROWS_AS(Store::get()->allocate(), std::bad_alloc);
+    for(auto ptr : unique){ Store::get()->deallocate(ptr); }
+}
+
+TEST_CASE("ConcurrentFreeStoreGrowth","[allocator]"){
+
+    using Storage = BlockListStorage<sizeof(Slot), sizeof(Slot) * 64>;
+    using Store = ConcurrentFreeStore<sizeof(Slot), Storage>;
+
+    const size_t numThreads = 8;
+    const size_t perThread = 1000;
+
+    std::vector<std::vector<void*>> owned(numThreads);
+    std::vector<std::thread> threads;
+    for(size_t t = 0; t < numThreads; t++){
+        threads.emplace_back([&owned, t, perThread]{
+            for(size_t i = 0; i < perThread; i++){
+                owned[t].push_back(Store::get()->allocate());
+            }
+        });
+    }
+    for(auto& thread : threads){ thread.join(); }
+
+    std::set<void*> unique;
+    for(auto& ptrs : owned){
+        unique.insert(ptrs.begin(), ptrs.end());
+    }
+    REQUIRE(unique.size() == numThreads * perThread);
+    REQUIRE(Store::get()->capacity() >= numThreads * perThread);
+
+    for(auto ptr : unique){ Store::get()->deallocate(ptr); }
+}
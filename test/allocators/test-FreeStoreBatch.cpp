@@ -0,0 +1,101 @@
+//
+//  test-FreeStoreBatch.cpp
+//  MemoryManagement
+//
+
+#include <chrono>
+#include <iostream>
+#include <set>
+#include <vector>
+#include "catch.hpp"
+#include "Allocator.hpp"
+#include "FreeStoreAllocator.hpp"
+
+struct Sample {
+    uint64_t timestamp;
+    double value;
+};
+
+TEST_CASE("FreeStoreBatchFixed","[allocator]"){
+
+    using Storage = FixedSizeStorage<sizeof(Sample), sizeof(Sample) * 1000>;
+    auto store = FreeStore<sizeof(Sample), Storage>::get();
+
+    std::vector<void*> batch(600);
+    store->allocate_n(batch.data(), batch.size());
+    REQUIRE(std::set<void*>(batch.begin(), batch.end()).size() == batch.size());
+
+    // fresh slots are carved back to back
+    for(size_t i = 1; i < batch.size(); i++){
+        REQUIRE(static_cast<char*>(batch[i]) - static_cast<char*>(batch[i - 1]) == Storage::OBJECT_SIZE);
+    }
+
+    // returning a batch splices it onto the free list, so it comes back as a run
+    store->deallocate_n(batch.data(), batch.size());
+    std::vector<void*> again(600);
+    store->allocate_n(again.data(), again.size());
+    REQUIRE(again == batch);
+
+    // a batch that cannot be met takes nothing
+    std::vector<void*> tooMany(500);
+    REQUIRE_THROWS_AS(store->allocate_n(tooMany.data(), tooMany.size()), std::bad_alloc);
+    std::vector<void*> rest(400);
+    store->allocate_n(rest.data(), rest.size());
+
+    std::set<void*> all(batch.begin(), batch.end());
+    all.insert(rest.begin(), rest.end());
+    REQUIRE(all.size() == 1000);
+
+    store->deallocate_n(rest.data(), rest.size());
+    store->deallocate_n(again.data(), again.size());
+}
+
+TEST_CASE("FreeStoreAllocatorBatchDynamic","[allocator]"){
+
+    using Alloc = Allocator<Sample, FreeStoreAllocator<Sample, BlockListStorage, 1024>>;
+    Alloc alloc;
+
+    // spans several blocks
+    std::vector<Sample*> batch(1000);
+    alloc.allocate_n(batch.data(), batch.size());
+    REQUIRE(std::set<Sample*>(batch.begin(), batch.end()).size() == batch.size());
+    REQUIRE(alloc.capacity() >= batch.size());
+    for(size_t i = 0; i < batch.size(); i++){
+        alloc.construct(batch[i], Sample{i, 0.5});
+    }
+    for(size_t i = 0; i < batch.size(); i++){
+        REQUIRE(batch[i]->timestamp == i);
+    }
+
+    alloc.deallocate_n(batch.data(), batch.size());
+    REQUIRE(alloc.allocate() == batch[0]);
+    alloc.deallocate(batch[0]);
+}
+
+TEST_CASE("FreeStoreBatchThroughput","[.][benchmark]"){
+
+    using Alloc = Allocator<Sample, FreeStoreAllocator<Sample, BlockListStorage, 65536>>;
+    Alloc alloc;
+    const size_t rounds = 1000;
+
+    for(size_t size = 256; size <= 4096; size *= 4){
+        std::vector<Sample*> batch(size);
+
+        auto start = std::chrono::steady_clock::now();
+        for(size_t r = 0; r < rounds; r++){
+            for(auto& ptr : batch){ ptr = alloc.allocate(); }
+            for(auto ptr : batch){ alloc.deallocate(ptr); }
+        }
+        auto single = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+        for(size_t r = 0; r < rounds; r++){
+            alloc.allocate_n(batch.data(), size);
+            alloc.deallocate_n(batch.data(), size);
+        }
+        auto batched = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << "batch of " << size << ": single " << single / (rounds * size) << " ns/object, batched "
+                  << batched / (rounds * size) << " ns/object" << std::endl;
+    }
+}
@@ -0,0 +1,97 @@
+//
+//  test-FreeStorePool.cpp
+//  MemoryManagement
+//
+
+#include <list>
+#include <map>
+#include <set>
+#include <vector>
+#include "catch.hpp"
+#include "Allocator.hpp"
+#include "ConcurrentFreeStore.hpp"
+#include "FreeStoreAllocator.hpp"
+#include "FreeStorePool.hpp"
+#include "MagazineFreeStore.hpp"
+
+namespace {
+    struct Message { char payload[48]; };
+    using MessageAlloc = Allocator<Message, FreeStoreAllocator<Message, BlockListStorage, 4096>>;
+}
+
+TEST_CASE("FreeStorePoolsAreSeparate","[pool]"){
+
+    FreeStorePool first;
+    FreeStorePool second;
+    MessageAlloc fromFirst(first);
+    MessageAlloc fromSecond(second);
+    MessageAlloc shared;
+
+    REQUIRE(fromFirst.store() == first.store<MessageAlloc::store_type>());
+    REQUIRE(fromFirst.store() != fromSecond.store());
+    REQUIRE(shared.store() == MessageAlloc::store_type::get());
+
+    std::set<Message*> seen;
+    for(int i = 0; i < 200; i++){
+        REQUIRE(seen.insert(fromFirst.allocate()).second);
+        REQUIRE(seen.insert(fromSecond.allocate()).second);
+    }
+    REQUIRE(first.capacity() == fromFirst.capacity());
+    REQUIRE(first.capacity() >= 200);
+
+    // equal only when the pool is the same
+    REQUIRE(fromFirst == MessageAlloc(first));
+    REQUIRE(fromFirst != fromSecond);
+    REQUIRE(fromFirst != shared);
+    REQUIRE(shared == MessageAlloc());
+}
+
+TEST_CASE("FreeStorePoolContainers","[pool]"){
+
+    FreeStorePool connection;
+    {
+        using Node = std::pair<const int, int>;
+        using NodeAlloc = Allocator<Node, FreeStoreAllocator<Node, BlockListStorage, 4096>>;
+        std::map<int, int, std::less<int>, NodeAlloc> sessions{std::less<int>(), NodeAlloc(connection)};
+        std::list<int, Allocator<int, FreeStoreAllocator<int, BlockListStorage, 4096>>> queue{
+            Allocator<int, FreeStoreAllocator<int, BlockListStorage, 4096>>(connection)};
+        for(int i = 0; i < 1000; i++){
+            sessions[i] = i;
+            queue.push_back(i);
+        }
+        // the rebound node stores live in the pool
+        REQUIRE(connection.stores() >= 2);
+        REQUIRE(connection.capacity() >= 2000);
+
+        // same pool, so a move keeps the nodes
+        auto moved = std::move(queue);
+        REQUIRE(moved.size() == 1000);
+        REQUIRE(moved.get_allocator() == queue.get_allocator());
+        REQUIRE(sessions.get_allocator() == NodeAlloc(connection));
+    }
+    REQUIRE(connection.stores() >= 2);
+
+    // dropping the connection's pool returns its blocks even with objects outstanding
+    MessageAlloc alloc(connection);
+    for(int i = 0; i < 500; i++){
+        alloc.allocate();
+    }
+    connection.clear();
+    REQUIRE(connection.stores() == 0);
+    REQUIRE(connection.capacity() == 0);
+}
+
+TEST_CASE("FreeStorePoolStoreTypes","[pool]"){
+
+    REQUIRE(is_poolable_store<FreeStore<64, BlockListStorage<64, 4096>>>::value);
+    REQUIRE(is_poolable_store<CountedFreeStore<64, BlockListStorage<64, 4096>>>::value);
+    REQUIRE_FALSE(is_poolable_store<MagazineFreeStore<64, BlockListStorage<64, 4096>>>::value);
+    REQUIRE_FALSE(is_poolable_store<ConcurrentFreeStore<64, BlockListStorage<64, 4096>>>::value);
+
+    // thread caching stores still rebind, always onto their singletons
+    using Cached = FreeStoreAllocator<Message, BlockListStorage, 4096, MagazineFreeStore>;
+    Cached cached;
+    Cached::rebind<int>::other rebound(cached);
+    REQUIRE(rebound.pool() == nullptr);
+    REQUIRE(rebound.store() == Cached::rebind<int>::other::store_type::get());
+}
@@ -0,0 +1,105 @@
+//
+//  test-FreeStoreTrim.cpp
+//  MemoryManagement
+//
+
+#include <set>
+#include <vector>
+#include "catch.hpp"
+#include "FreeStore.hpp"
+#include "MmapStorage.hpp"
+
+TEST_CASE("FreeStoreTrimBlockList","[allocator]"){
+
+    using Storage = BlockListStorage<40, 1024>;
+    using Store = FreeStore<40, Storage, AllocationStatistics>;
+    const size_t perBlock = Storage::OBJECTS_PER_BLOCK;
+
+    auto store = Store::get();
+    std::vector<void*> slots;
+    for(size_t i = 0; i < perBlock * 10; i++){
+        slots.push_back(store->allocate());
+    }
+    REQUIRE(store->statistics().blocks_reserved == 10);
+
+    // keep one object alive in blocks 0, 1, 6 and 7, everything else is freed
+    std::vector<void*> live;
+    for(size_t i = 0; i < slots.size(); i++){
+        auto block = i / perBlock;
+        bool keep = (block < 2 || block == 6 || block == 7) && i % perBlock == 3;
+        if(keep){
+            live.push_back(slots[i]);
+        }else{
+            store->deallocate(slots[i]);
+        }
+    }
+
+    // blocks 2-5 are reused later, 8 and 9 at the top just lower the carve index
+    REQUIRE(store->trim() == 6);
+    auto snapshot = store->statistics();
+    REQUIRE(snapshot.blocks_reserved == 4);
+    REQUIRE(snapshot.high_water_mark == perBlock * 10);
+    REQUIRE(snapshot.live == 4);
+    REQUIRE(snapshot.free_list_length == 4 * (perBlock - 1));
+    REQUIRE(store->trim() == 0);
+
+    // the free list, then the trimmed blocks, then fresh blocks
+    std::set<void*> seen(live.begin(), live.end());
+    std::vector<void*> again;
+    for(size_t i = 0; i < perBlock * 10 - live.size(); i++){
+        again.push_back(store->allocate());
+        REQUIRE(seen.insert(again.back()).second);
+    }
+    REQUIRE(store->statistics().blocks_reserved == 10);
+    REQUIRE(store->statistics().high_water_mark == perBlock * 10);
+
+    for(auto slot : again){ store->deallocate(slot); }
+    for(auto slot : live){ store->deallocate(slot); }
+    REQUIRE(store->trim() == 10);
+    // trimming gives the blocks back but the peak stays where it was
+    REQUIRE(store->statistics().high_water_mark == perBlock * 10);
+    REQUIRE(store->statistics().blocks_reserved == 0);
+}
+
+TEST_CASE("FreeStoreTrimMmap","[allocator]"){
+
+    using Storage = MmapStorage<64, size_t(1) << 24>;
+    using Store = FreeStore<64, Storage>;
+
+    auto store = Store::get();
+    std::vector<char*> slots;
+    for(size_t i = 0; i < Storage::RELEASE_OBJECTS * 4; i++){
+        slots.push_back(static_cast<char*>(store->allocate()));
+        slots.back()[32] = 1;
+    }
+    for(auto slot : slots){ store->deallocate(slot); }
+    REQUIRE(store->trim() == 4);
+    REQUIRE(store->statistics().high_water_mark == Storage::RELEASE_OBJECTS * 4);
+
+    // purged pages come back zeroed at the same addresses
+    for(size_t i = 0; i < slots.size(); i++){
+        auto slot = static_cast<char*>(store->allocate());
+        REQUIRE(slot == slots[i]);
+        REQUIRE(slot[32] == 0);
+    }
+}
+
+TEST_CASE("FreeStoreAutoTrim","[allocator]"){
+
+    using Storage = BlockListStorage<48, 1024>;
+    using Store = FreeStore<48, Storage>;
+
+    auto store = Store::get();
+    store->setAutoTrim(Storage::OBJECTS_PER_BLOCK * 4);
+
+    std::vector<void*> slots(Storage::OBJECTS_PER_BLOCK * 4);
+    store->allocate_n(slots.data(), slots.size());
+    REQUIRE(store->statistics().blocks_reserved == 4);
+    store->deallocate_n(slots.data(), slots.size() / 2);
+    REQUIRE(store->statistics().blocks_reserved == 4);
+    for(size_t i = slots.size() / 2; i < slots.size(); i++){
+        store->deallocate(slots[i]);
+    }
+    REQUIRE(store->statistics().blocks_reserved == 0);
+    store->setAutoTrim(0);
+}
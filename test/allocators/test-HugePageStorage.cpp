@@ -0,0 +1,49 @@
+//
+//  test-HugePageStorage.cpp
+//  MemoryManagement
+//
+
+#include "catch.hpp"
+#include "Allocator.hpp"
+#include "FreeStoreAllocator.hpp"
+#include "HugePageStorage.hpp"
+
+TEST_CASE("HugePageStorage","[storage]"){
+
+    const size_t hugePage = HugePageBlocks::HUGE_PAGE_SIZE;
+    using Storage = HugePageStorage<64, 2 * 1024 * 1024>;
+    REQUIRE(Storage::BLOCK_SIZE == hugePage);
+
+    auto before = HugePageBlocks::report();
+    Storage storage;
+    auto after = HugePageBlocks::report();
+    const char* modes[] = {"regular", "transparent", "explicit"};
+    INFO("huge page blocks mapped as " << modes[static_cast<int>(HugePageBlocks::mode())]);
+
+    REQUIRE(after.explicitBlocks + after.transparentBlocks + after.regularBlocks ==
+            before.explicitBlocks + before.transparentBlocks + before.regularBlocks + 1);
+
+    // blocks start on a huge page boundary and come back zeroed
+    auto first = static_cast<char*>(storage[0]);
+    REQUIRE(reinterpret_cast<uintptr_t>(first) % hugePage == 0);
+    REQUIRE(first[0] == 0);
+    REQUIRE(first[Storage::BLOCK_SIZE - 1] == 0);
+
+    auto second = static_cast<char*>(storage[Storage::OBJECTS_PER_BLOCK]);
+    REQUIRE(reinterpret_cast<uintptr_t>(second) % hugePage == 0);
+    REQUIRE(storage.capacity() == 2 * Storage::OBJECTS_PER_BLOCK);
+}
+
+TEST_CASE("FreeStoreAllocatorHugePages","[allocator]"){
+
+    struct Particle { float position[4]; float velocity[4]; };
+    using Alloc = Allocator<Particle, FreeStoreAllocator<Particle, HugePageStorage, 2 * 1024 * 1024>>;
+
+    Alloc alloc;
+    auto first = alloc.allocate();
+    auto second = alloc.allocate();
+    REQUIRE(second - first == 1);
+    alloc.deallocate(second);
+    alloc.deallocate(first);
+    REQUIRE(alloc.allocate() == first);
+}
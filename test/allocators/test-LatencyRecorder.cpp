@@ -0,0 +1,131 @@
+//
+//  test-LatencyRecorder.cpp
+//  MemoryManagement
+//
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include "catch.hpp"
+#include "LatencyRecorder.hpp"
+
+TEST_CASE("LatencyHistogramBuckets","[latency]"){
+
+    // every bucket's bounds map back onto it and never overlap the next
+    for(size_t b = 0; b + 1 < LatencyHistogram::BUCKETS; b++){
+        REQUIRE(LatencyHistogram::bucket(LatencyHistogram::lowest(b)) == b);
+        REQUIRE(LatencyHistogram::bucket(LatencyHistogram::highest(b)) == b);
+        REQUIRE(LatencyHistogram::highest(b) + 1 == LatencyHistogram::lowest(b + 1));
+    }
+    REQUIRE(LatencyHistogram::bucket(UINT64_MAX) == LatencyHistogram::BUCKETS - 1);
+
+    // bucket width stays within 1/16 of the values it holds
+    for(uint64_t value : {17ull, 1000ull, 123456ull, 987654321ull}){
+        auto b = LatencyHistogram::bucket(value);
+        REQUIRE(LatencyHistogram::highest(b) - LatencyHistogram::lowest(b) <= value / LatencyHistogram::SUB_BUCKETS);
+    }
+}
+
+TEST_CASE("LatencyHistogramPercentiles","[latency]"){
+
+    LatencyHistogram histogram;
+    for(uint64_t i = 1; i <= 10000; i++){
+        histogram.record(i);
+    }
+    REQUIRE(histogram.count() == 10000);
+    REQUIRE(histogram.min() == 1);
+    REQUIRE(histogram.max() == 10000);
+    REQUIRE(histogram.mean() == Approx(5000.5));
+    REQUIRE(histogram.percentile(50) >= 5000);
+    REQUIRE(histogram.percentile(50) <= 5000 + 5000 / 16);
+    REQUIRE(histogram.percentile(99.9) >= 9990);
+    REQUIRE(histogram.percentile(100) == 10000);
+
+    LatencyHistogram spikes;
+    spikes.record(1000000);
+    histogram.merge(spikes);
+    REQUIRE(histogram.count() == 10001);
+    REQUIRE(histogram.max() == 1000000);
+    REQUIRE(histogram.percentile(100) == 1000000);
+}
+
+TEST_CASE("LatencyRecorderThreads","[latency]"){
+
+    LatencyRecorder recorder("test-threads", 1);
+    std::vector<std::thread> threads;
+    for(int t = 0; t < 4; t++){
+        threads.emplace_back([&recorder, t]{
+            for(uint64_t i = 0; i < 1000; i++){
+                recorder.record(t * 1000 + i);
+            }
+        });
+    }
+    for(auto& thread : threads){ thread.join(); }
+
+    auto merged = recorder.merged();
+    REQUIRE(merged.count() == 4000);
+    REQUIRE(merged.min() == 0);
+    REQUIRE(merged.max() == 3999);
+}
+
+TEST_CASE("LatencyRecorderSampling","[latency]"){
+
+    LatencyRecorder recorder("test-sampling", 16);
+    for(int i = 0; i < 1600; i++){
+        LatencyRecorder::Sample sample(recorder);
+    }
+    REQUIRE(recorder.merged().count() == 100);
+
+    recorder.setSamplePeriod(0);
+    for(int i = 0; i < 1600; i++){
+        LatencyRecorder::Sample sample(recorder);
+    }
+    REQUIRE(recorder.merged().count() == 100);
+}
+
+TEST_CASE("LatencyRecorderInterleaved","[latency]"){
+
+    // an allocate and deallocate pair called in lockstep, each keeps its own sampling tick
+    LatencyRecorder allocate("test-interleaved-allocate", 16);
+    LatencyRecorder deallocate("test-interleaved-deallocate", 16);
+    for(int i = 0; i < 1600; i++){
+        { LatencyRecorder::Sample sample(allocate); }
+        { LatencyRecorder::Sample sample(deallocate); }
+    }
+    REQUIRE(allocate.merged().count() == 100);
+    REQUIRE(deallocate.merged().count() == 100);
+}
+
+TEST_CASE("LatencyRecorderShortLived","[latency]"){
+
+    // recorders come and go on a thread while a long lived one keeps its own shard
+    LatencyRecorder outer("test-outer", 1);
+    for(int i = 0; i < 1000; i++){
+        LatencyRecorder inner("test-inner", 1);
+        inner.record(i);
+        outer.record(i);
+        REQUIRE(inner.merged().count() == 1);
+    }
+    REQUIRE(outer.merged().count() == 1000);
+    REQUIRE(outer.merged().max() == 999);
+}
+
+TEST_CASE("LatencyRecorderDump","[latency]"){
+
+    LatencyRecorder recorder("test-dump", 1);
+    recorder.record(42);
+    recorder.record(4200);
+
+    auto path = "test-LatencyRecorder.txt";
+    REQUIRE(LatencyRecorder::dumpAll(path));
+    std::ifstream in(path);
+    std::stringstream contents;
+    contents << in.rdbuf();
+    in.close();
+    std::remove(path);
+
+    REQUIRE(contents.str().find("# test-dump\ncount=2") != std::string::npos);
+    REQUIRE(contents.str().find("42 43 1\n") != std::string::npos);
+}
@@ -0,0 +1,78 @@
+//
+//  test-LazyStorage.cpp
+//  MemoryManagement
+//
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include "catch.hpp"
+#include "LazyStorage.hpp"
+
+#if !defined(_WIN32)
+// pages of [ptr, ptr + bytes) currently backed by physical memory
+static size_t residentPages(void* ptr, size_t bytes){
+    auto page = VirtualMemory::pageSize();
+    std::vector<unsigned char> resident((bytes + page - 1) / page);
+    mincore(ptr, bytes, resident.data());
+    size_t count = 0;
+    for(auto flag : resident){ count += flag & 1; }
+    return count;
+}
+#endif
+
+TEST_CASE("LazyFixedSizeStorage","[storage]"){
+
+    using Storage = LazyFixedSizeStorage<16, 16 * 1024 * 1024>;
+    Storage storage;
+
+    auto first = static_cast<char*>(storage[0]);
+#if defined(MADV_NOHUGEPAGE)
+    // with transparent huge pages set to always the first touch would back a whole 2 MiB page,
+    // the counts below are in base pages
+    madvise(first, VirtualMemory::roundToPages(Storage::BLOCK_SIZE), MADV_NOHUGEPAGE);
+#endif
+    REQUIRE(first[0] == 0);
+    REQUIRE(static_cast<char*>(storage[Storage::OBJECTS_PER_BLOCK - 1])[15] == 0);
+
+#if !defined(_WIN32)
+    // only the pages read so far are backed
+    REQUIRE(residentPages(first, Storage::BLOCK_SIZE) <= 2);
+    auto page = VirtualMemory::pageSize();
+    for(size_t i = 0; i < 4 * page / Storage::OBJECT_SIZE; i++){
+        static_cast<char*>(storage[i])[0] = 1;
+    }
+    REQUIRE(residentPages(first, 4 * page) == 4);
+    REQUIRE(residentPages(first, Storage::BLOCK_SIZE) <= 6);
+#endif
+}
+
+TEST_CASE("LazyBlockListStorage","[storage]"){
+
+    using Store = FreeStore<24, LazyBlockListStorage<24, 65536>>;
+    auto store = Store::get();
+
+    std::vector<void*> slots;
+    for(int i = 0; i < 10000; i++){
+        slots.push_back(store->allocate());
+        static_cast<char*>(slots.back())[23] = 1;
+    }
+    for(auto slot : slots){ store->deallocate(slot); }
+    REQUIRE(store->trim() > 0);
+}
+
+TEST_CASE("LazyStorageStartup","[.][benchmark]"){
+
+    const size_t objects = 1000000;
+    const size_t bytes = objects * 16;
+    auto time = [](const char* label, std::function<void()> construct){
+        auto start = std::chrono::steady_clock::now();
+        construct();
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        std::cout << label << " " << elapsed << "us" << std::endl;
+    };
+    time("FixedSizeStorage 1M objects", []{ std::unique_ptr<FixedSizeStorage<16, bytes>> storage(new FixedSizeStorage<16, bytes>); });
+    time("LazyFixedSizeStorage 1M objects", []{ std::unique_ptr<LazyFixedSizeStorage<16, bytes>> storage(new LazyFixedSizeStorage<16, bytes>); });
+}
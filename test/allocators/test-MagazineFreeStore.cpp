@@ -0,0 +1,132 @@
+//
+//  test-MagazineFreeStore.cpp
+//  MemoryManagement
+//
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <set>
+#include <chrono>
+#include <iostream>
+#include "catch.hpp"
+#include "Allocator.hpp"
+#include "FreeStoreAllocator.hpp"
+#include "MagazineFreeStore.hpp"
+
+struct Message {
+    Message(size_t owner = 0, size_t seq = 0):mOwner(owner),mSeq(seq){}
+    size_t mOwner;
+    size_t mSeq;
+    char mPayload[48];
+};
+
+using MessageAlloc = Allocator<Message, FreeStoreAllocator<Message, BlockListStorage, 4096, MagazineFreeStore>>;
+
+TEST_CASE("MagazineFreeStoreReuse","[allocator]"){
+
+    MessageAlloc alloc;
+
+    auto obj1 = alloc.allocate();
+    alloc.construct(obj1, 1, 1);
+    auto obj2 = alloc.allocate();
+    alloc.construct(obj2, 1, 2);
+    REQUIRE(obj1 != obj2);
+
+    alloc.destroy(obj2);
+    alloc.deallocate(obj2);
+    auto obj3 = alloc.allocate();
+    REQUIRE(obj3 == obj2);
+
+    alloc.deallocate(obj3);
+    alloc.destroy(obj1);
+    alloc.deallocate(obj1);
+}
+
+TEST_CASE("MagazineFreeStoreThreads","[allocator]"){
+
+    const size_t numThreads = 8;
+    const size_t perThread = 1000;
+
+    std::vector<std::vector<Message*>> owned(numThreads);
+    std::vector<std::thread> threads;
+
+    // every thread fills its own set of live objects
+    for(size_t t = 0; t < numThreads; t++){
+        threads.emplace_back([&owned, t, perThread]{
+            MessageAlloc alloc;
+            for(size_t i = 0; i < perThread; i++){
+                auto ptr = alloc.allocate();
+                alloc.construct(ptr, t, i);
+                owned[t].push_back(ptr);
+            }
+        });
+    }
+    for(auto& thread : threads){ thread.join(); }
+    threads.clear();
+
+    std::set<Message*> unique;
+    for(size_t t = 0; t < numThreads; t++){
+        for(size_t i = 0; i < perThread; i++){
+            REQUIRE(owned[t][i]->mOwner == t);
+            REQUIRE(owned[t][i]->mSeq == i);
+            unique.insert(owned[t][i]);
+        }
+    }
+    REQUIRE(unique.size() == numThreads * perThread);
+
+    // free everything from a thread that did not allocate it, then churn
+    std::atomic<bool> shared{false};
+    for(size_t t = 0; t < numThreads; t++){
+        threads.emplace_back([&owned, &shared, t, numThreads]{
+            MessageAlloc alloc;
+            for(auto ptr : owned[(t + 1) % numThreads]){
+                alloc.destroy(ptr);
+                alloc.deallocate(ptr);
+            }
+            std::vector<Message*> live;
+            for(size_t i = 0; i < 20000; i++){
+                if(live.size() < 200 && (i % 3) != 0){
+                    auto ptr = alloc.allocate();
+                    alloc.construct(ptr, t, i);
+                    live.push_back(ptr);
+                }else if(!live.empty()){
+                    auto ptr = live.back();
+                    live.pop_back();
+                    if(ptr->mOwner != t) shared = true;
+                    alloc.destroy(ptr);
+                    alloc.deallocate(ptr);
+                }
+            }
+            for(auto ptr : live){
+                alloc.destroy(ptr);
+                alloc.deallocate(ptr);
+            }
+        });
+    }
+    for(auto& thread : threads){ thread.join(); }
+
+    REQUIRE_FALSE(shared);
+}
+
+TEST_CASE("MagazineFreeStoreScaling","[.][benchmark]"){
+
+    for(size_t numThreads = 1; numThreads <= std::thread::hardware_concurrency(); numThreads *= 2){
+        const size_t iterations = 1000000;
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for(size_t t = 0; t < numThreads; t++){
+            threads.emplace_back([iterations]{
+                MessageAlloc alloc;
+                Message* batch[32];
+                for(size_t i = 0; i < iterations; i += 32){
+                    for(auto& ptr : batch){ ptr = alloc.allocate(); }
+                    for(auto& ptr : batch){ alloc.deallocate(ptr); }
+                }
+            });
+        }
+        for(auto& thread : threads){ thread.join(); }
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << numThreads << " threads: " << (numThreads * iterations * 2) / elapsed / 1e6 << " Mops/s" << std::endl;
+    }
+}
@@ -0,0 +1,118 @@
+//
+//  test-MemoryResource.cpp
+//  MemoryManagement
+//
+
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "catch.hpp"
+#include "MemoryResource.hpp"
+
+namespace {
+    // counts what reaches it, to check what a resource passes upstream
+    class CountingResource : public std::pmr::memory_resource {
+    public:
+        size_t allocations{0};
+        size_t bytes{0};
+    protected:
+        void* do_allocate(size_t size, size_t alignment) override {
+            ++allocations;
+            bytes += size;
+            return HeapResource::get()->allocate(size, alignment);
+        }
+        void do_deallocate(void* ptr, size_t size, size_t alignment) override {
+            --allocations;
+            bytes -= size;
+            HeapResource::get()->deallocate(ptr, size, alignment);
+        }
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+    };
+}
+
+TEST_CASE("HeapResourceAlignment","[pmr]"){
+
+    auto heap = HeapResource::get();
+    auto ptr = heap->allocate(100, 256);
+    REQUIRE(reinterpret_cast<uintptr_t>(ptr) % 256 == 0);
+    heap->deallocate(ptr, 100, 256);
+    HeapResource other;
+    REQUIRE(heap->is_equal(other));
+}
+
+TEST_CASE("FreeStoreResourceList","[pmr]"){
+
+    CountingResource upstream;
+    FreeStorePool pool;
+    // list nodes are two pointers and the value
+    FreeStoreResource<24, BlockListStorage<24, 4096>> nodes(pool, &upstream);
+    {
+        std::pmr::list<int> values(&nodes);
+        for(int i = 0; i < 1000; i++){
+            values.push_back(i);
+        }
+        REQUIRE(nodes.store()->capacity() >= 1000);
+        REQUIRE(upstream.allocations == 0);
+
+        // too big for a slot, served upstream
+        auto big = nodes.allocate(64);
+        REQUIRE(upstream.allocations == 1);
+        nodes.deallocate(big, 64);
+        REQUIRE(upstream.allocations == 0);
+    }
+    FreeStoreResource<24, BlockListStorage<24, 4096>> same(pool);
+    REQUIRE(same.store() == nodes.store());
+    REQUIRE_FALSE(nodes.is_equal(FreeStoreResource<24, BlockListStorage<24, 4096>>()));
+}
+
+TEST_CASE("PoolResourceChaining","[pmr]"){
+
+    CountingResource counting;
+    ArenaResource arena(4096, &counting);
+    PoolResource<> pool(&arena);
+    {
+        std::pmr::unordered_map<int, std::pmr::string> names(&pool);
+        for(int i = 0; i < 2000; i++){
+            names.emplace(i, std::pmr::string("a name long enough to need a buffer", &pool));
+        }
+        REQUIRE(names.at(1999) == "a name long enough to need a buffer");
+
+        // only the bucket array outgrows the size classes and reaches the arena
+        REQUIRE(arena.arena().used() > 2000 * sizeof(void*));
+        REQUIRE(counting.allocations > 0);
+        REQUIRE(counting.bytes > arena.arena().reserved());
+    }
+
+    // alignment beyond a class goes upstream as well
+    auto used = arena.arena().used();
+    auto aligned = pool.allocate(64, 4096);
+    REQUIRE(reinterpret_cast<uintptr_t>(aligned) % 4096 == 0);
+    REQUIRE(arena.arena().used() > used);
+    pool.deallocate(aligned, 64, 4096);
+
+    arena.release();
+    REQUIRE(arena.arena().used() == 0);
+}
+
+TEST_CASE("StdResourcesOverStores","[pmr]"){
+
+    // the standard resources chain onto ours like any other upstream
+    PoolResource<> pool;
+    std::pmr::monotonic_buffer_resource monotonic(1024, &pool);
+    std::pmr::vector<double> values(&monotonic);
+    for(int i = 0; i < 100; i++){
+        values.push_back(i);
+    }
+    REQUIRE(values.back() == 99);
+
+    Stack stack(4096);
+    StackResource frame(stack);
+    {
+        std::pmr::vector<int> scratch(&frame);
+        scratch.reserve(100);
+        REQUIRE(stack.used() >= 100 * sizeof(int));
+    }
+    // the vector's buffer was the top of the stack
+    REQUIRE(stack.used() == 0);
+}
@@ -0,0 +1,59 @@
+//
+//  test-MmapStorage.cpp
+//  MemoryManagement
+//
+
+#include "catch.hpp"
+#include "Allocator.hpp"
+#include "FreeStoreAllocator.hpp"
+#include "MmapStorage.hpp"
+
+TEST_CASE("MmapStorageCommit","[storage]"){
+
+    using Storage = MmapStorage<24, size_t(1) << 30>;
+    Storage storage;
+
+    REQUIRE(storage.committed() == 0);
+    REQUIRE(storage.capacity() == (size_t(1) << 30) / 24);
+
+    auto first = static_cast<char*>(storage[0]);
+    REQUIRE(storage.committed() == Storage::COMMIT_SIZE);
+    first[0] = 1;
+
+    // crossing into the next chunk commits only that chunk
+    auto index = Storage::COMMIT_SIZE / Storage::OBJECT_SIZE;
+    auto next = static_cast<char*>(storage[index]);
+    REQUIRE(storage.committed() == 2 * Storage::COMMIT_SIZE);
+    REQUIRE(size_t(next - first) == index * Storage::OBJECT_SIZE);
+    REQUIRE(storage.index_of(next) == index);
+    REQUIRE(storage.contains(next));
+    REQUIRE_FALSE(storage.contains(first + Storage::BLOCK_SIZE));
+    next[Storage::OBJECT_SIZE - 1] = 1;
+
+    REQUIRE_THROWS_AS(storage[Storage::OBJECTS_PER_BLOCK], std::bad_alloc);
+}
+
+TEST_CASE("FreeStoreAllocatorMmap","[allocator]"){
+
+    struct Record { double values[3]; };
+    using Alloc = Allocator<Record, FreeStoreAllocator<Record, MmapStorage, 4096>>;
+    using Storage = MmapStorage<sizeof(Record), 4096>;
+
+    Alloc alloc;
+    REQUIRE(alloc.capacity() == Storage::OBJECTS_PER_BLOCK);
+
+    // fresh slots are handed out back to back
+    std::vector<Record*> records;
+    for(size_t i = 0; i < Storage::OBJECTS_PER_BLOCK; i++){
+        records.push_back(alloc.allocate());
+        alloc.construct(records.back());
+        records.back()->values[0] = i;
+    }
+    for(size_t i = 1; i < records.size(); i++){
+        REQUIRE(records[i] - records[i - 1] == 1);
+    }
+    REQUIRE_THROWS_AS(alloc.allocate(), std::bad_alloc);
+
+    alloc.deallocate(records[7]);
+    REQUIRE(alloc.allocate() == records[7]);
+}
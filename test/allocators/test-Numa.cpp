@@ -0,0 +1,170 @@
+//
+//  test-Numa.cpp
+//  MemoryManagement
+//
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "catch.hpp"
+#include "Allocator.hpp"
+#include "FreeStoreAllocator.hpp"
+#include "NumaFreeStore.hpp"
+
+namespace {
+
+// Two node machine that records where blocks were bound
+class FakeTopology : public NumaTopology {
+public:
+    int nodes() override { return 2; }
+    int current_node() override { return current; }
+    bool bind(void* ptr, size_t bytes, int node) override {
+        bound.emplace_back(ptr, node);
+        return true;
+    }
+    int node_bound(void* ptr) const {
+        for(auto& block : bound){
+            if(block.first == ptr) return block.second;
+        }
+        return -1;
+    }
+    int current{0};
+    std::vector<std::pair<void*, int>> bound;
+};
+
+struct TopologyScope {
+    explicit TopologyScope(NumaTopology* topology){ Numa::setTopology(topology); }
+    ~TopologyScope(){ Numa::setTopology(nullptr); }
+};
+
+}
+
+TEST_CASE("NumaBlocks","[storage]"){
+
+    FakeTopology topology;
+    TopologyScope scope(&topology);
+
+    const size_t bytes = 64 * 1024;
+    auto first = NumaBlocks<1>::allocate(bytes, 64);
+    REQUIRE(topology.node_bound(first) == 1);
+    REQUIRE(NumaRegions::get()->node_of(first) == 1);
+
+    // local blocks follow the calling thread, a binding scope overrides it
+    topology.current = 0;
+    auto local = NumaBlocks<NUMA_LOCAL>::allocate(bytes, 64);
+    REQUIRE(topology.node_bound(local) == 0);
+    {
+        Numa::Binding binding(1);
+        auto bound = NumaBlocks<NUMA_LOCAL>::allocate(bytes, 64);
+        REQUIRE(topology.node_bound(bound) == 1);
+        NumaBlocks<NUMA_LOCAL>::deallocate(bound, bytes, 64);
+    }
+
+    // nodes past the topology wrap around rather than fail
+    auto wrapped = NumaBlocks<3>::allocate(bytes, 64);
+    REQUIRE(topology.node_bound(wrapped) == 1);
+
+    // freed blocks are reused on their node and come back zeroed
+    static_cast<char*>(first)[0] = 1;
+    NumaBlocks<1>::deallocate(first, bytes, 64);
+    auto reused = NumaBlocks<1>::allocate(bytes, 64);
+    REQUIRE(reused == first);
+    REQUIRE(static_cast<char*>(reused)[0] == 0);
+
+    NumaBlocks<1>::deallocate(reused, bytes, 64);
+    NumaBlocks<1>::deallocate(wrapped, bytes, 64);
+    NumaBlocks<0>::deallocate(local, bytes, 64);
+    REQUIRE(NumaRegions::get()->node_of(&topology) == -1);
+}
+
+TEST_CASE("NumaRegionsConcurrentLookup","[storage]"){
+
+    FakeTopology topology;
+    TopologyScope scope(&topology);
+
+    // lookups need no lock, they run while another thread carves and frees blocks
+    const size_t bytes = 64 * 1024;
+    auto known = NumaBlocks<1>::allocate(bytes, 64);
+    std::atomic<bool> stop{false};
+    std::atomic<int> wrong{0};
+    std::vector<std::thread> readers;
+    for(int t = 0; t < 3; t++){
+        readers.emplace_back([&]{
+            while(!stop.load(std::memory_order_relaxed)){
+                if(NumaRegions::get()->node_of(known) != 1) ++wrong;
+            }
+        });
+    }
+    for(int i = 0; i < 200; i++){
+        auto block = NumaBlocks<NUMA_LOCAL>::allocate(bytes, 64);
+        REQUIRE(NumaRegions::get()->node_of(block) == 0);
+        NumaBlocks<NUMA_LOCAL>::deallocate(block, bytes, 64);
+    }
+    stop = true;
+    for(auto& reader : readers){ reader.join(); }
+    REQUIRE(wrong == 0);
+    NumaBlocks<1>::deallocate(known, bytes, 64);
+}
+
+TEST_CASE("NumaFreeStore","[allocator]"){
+
+    FakeTopology topology;
+    TopologyScope scope(&topology);
+
+    using Store = NumaFreeStore<64, NumaBlockListStorage<64, 64 * 1024>>;
+    Store store;
+    REQUIRE(store.nodes() == 2);
+
+    auto onZero = store.allocate_on(0);
+    auto onOne = store.allocate_on(1);
+    REQUIRE(NumaRegions::get()->node_of(onZero) == 0);
+    REQUIRE(NumaRegions::get()->node_of(onOne) == 1);
+
+    // slots go back to the store of the node they live on
+    store.deallocate(onOne);
+    REQUIRE(store.store(1)->has_free());
+    REQUIRE_FALSE(store.store(0)->has_free());
+    REQUIRE(store.store(1)->allocate() == onOne);
+    store.deallocate(onZero);
+    store.deallocate(onOne);
+    REQUIRE(store.allocate_on(0) == onZero);
+    REQUIRE(store.allocate_on(1) == onOne);
+    store.deallocate(onZero);
+    store.deallocate(onOne);
+
+    // a fixed node storage through FreeStoreAllocator
+    struct Particle { float position[4]; float velocity[4]; };
+    Allocator<Particle, FreeStoreAllocator<Particle, NumaNode<1>::BlockListStorage, 64 * 1024>> alloc;
+    auto particle = alloc.allocate();
+    REQUIRE(NumaRegions::get()->node_of(particle) == 1);
+    alloc.deallocate(particle);
+}
+
+TEST_CASE("NumaFreeStoreSystem","[allocator]"){
+
+    // whatever the machine, the system topology has to work, one node just means no binding
+    auto nodes = Numa::topology()->nodes();
+    INFO("numa nodes " << nodes);
+    REQUIRE(nodes >= 1);
+    REQUIRE(Numa::topology()->current_node() < nodes);
+
+    // nodes outside the node mask are refused rather than indexed
+    char page[64];
+    REQUIRE_FALSE(Numa::topology()->bind(page, sizeof(page), -1));
+    REQUIRE_FALSE(Numa::topology()->bind(page, sizeof(page), SystemNumaTopology::MAX_NODES));
+
+    struct Particle { float position[4]; float velocity[4]; };
+    Allocator<Particle, FreeStoreAllocator<Particle, NumaBlockListStorage, 64 * 1024, NumaFreeStore>> alloc;
+    std::vector<Particle*> particles;
+    for(int i = 0; i < 10000; i++){
+        particles.push_back(alloc.allocate());
+        particles.back()->position[0] = static_cast<float>(i);
+    }
+    for(int i = 0; i < 10000; i++){
+        REQUIRE(particles[i]->position[0] == static_cast<float>(i));
+        REQUIRE(NumaRegions::get()->node_of(particles[i]) >= 0);
+    }
+    for(auto particle : particles){
+        alloc.deallocate(particle);
+    }
+}
@@ -0,0 +1,125 @@
+//
+//  test-OwnerFreeStore.cpp
+//  MemoryManagement
+//
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+#include "catch.hpp"
+#include "ConcurrentFreeStore.hpp"
+#include "OwnerFreeStore.hpp"
+
+namespace {
+
+    // single producer, single consumer ring of pointers
+    struct Ring {
+        static const size_t SIZE = 1024;
+        void* slots[SIZE];
+        std::atomic<size_t> head{0};
+        std::atomic<size_t> tail{0};
+
+        void push(void* ptr){
+            auto h = head.load(std::memory_order_relaxed);
+            while(h - tail.load(std::memory_order_acquire) == SIZE){ std::this_thread::yield(); }
+            slots[h % SIZE] = ptr;
+            head.store(h + 1, std::memory_order_release);
+        }
+        void* pop(){
+            auto t = tail.load(std::memory_order_relaxed);
+            while(head.load(std::memory_order_acquire) == t){ std::this_thread::yield(); }
+            auto ptr = slots[t % SIZE];
+            tail.store(t + 1, std::memory_order_release);
+            return ptr;
+        }
+    };
+
+    // one thread allocates messages, another frees them
+    template<typename Store>
+    double pipeline(size_t messages){
+        auto store = Store::get();
+        Ring ring;
+        auto start = std::chrono::steady_clock::now();
+        std::thread consumer([&]{
+            for(size_t i = 0; i < messages; i++){
+                store->deallocate(ring.pop());
+            }
+        });
+        for(size_t i = 0; i < messages; i++){
+            auto message = store->allocate();
+            *static_cast<size_t*>(message) = i;
+            ring.push(message);
+        }
+        consumer.join();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+TEST_CASE("OwnerFreeStoreRemoteFree","[allocator]"){
+
+    using Store = OwnerFreeStore<48, BlockListStorage<48, 16384>>;
+    auto store = Store::get();
+    REQUIRE(Store::SEGMENT_SIZE >= 16384 / 2);
+
+    // a pipeline never needs more than the messages in flight once remote frees come back
+    pipeline<Store>(100000);
+    auto capacity = store->capacity();
+    pipeline<Store>(100000);
+    REQUIRE(store->capacity() == capacity);
+    REQUIRE(capacity < 20 * Ring::SIZE);
+
+    // slots freed here come straight back here
+    auto slot = store->allocate();
+    store->deallocate(slot);
+    REQUIRE(store->allocate() == slot);
+    store->deallocate(slot);
+}
+
+TEST_CASE("OwnerFreeStoreAdoption","[allocator]"){
+
+    using Store = OwnerFreeStore<24, BlockListStorage<24, 4096>>;
+    auto store = Store::get();
+
+    std::vector<void*> held;
+    std::set<void*> freed;
+    std::thread([&]{
+        for(int i = 0; i < 300; i++){ held.push_back(store->allocate()); }
+        for(int i = 0; i < 100; i++){
+            store->deallocate(held.back());
+            freed.insert(held.back());
+            held.pop_back();
+        }
+    }).join();
+    auto owners = store->owners();
+    auto capacity = store->capacity();
+
+    // the exited thread's owner is adopted with its free slots, the rest are freed remotely
+    size_t reused = 0;
+    std::thread([&]{
+        for(int i = 0; i < 100; i++){
+            reused += freed.count(store->allocate());
+        }
+    }).join();
+    REQUIRE(reused == 100);
+    REQUIRE(store->owners() == owners);
+    REQUIRE(store->capacity() == capacity);
+
+    for(auto slot : held){ store->deallocate(slot); }
+    std::thread([&]{
+        for(int i = 0; i < 200; i++){ store->allocate(); }
+    }).join();
+    REQUIRE(store->capacity() == capacity);
+}
+
+TEST_CASE("OwnerFreeStorePipeline","[.][benchmark]"){
+
+    const size_t messages = 2000000;
+    auto owner = pipeline<OwnerFreeStore<64, BlockListStorage<64, 65536>>>(messages);
+    auto shared = pipeline<ConcurrentFreeStore<64, BlockListStorage<64, 65536>>>(messages);
+    std::cout << "producer/consumer " << messages << " messages: OwnerFreeStore " << messages / owner / 1e6
+              << " M/s, ConcurrentFreeStore " << messages / shared / 1e6 << " M/s" << std::endl;
+}
@@ -0,0 +1,86 @@
+//
+//  test-Relocation.cpp
+//  MemoryManagement
+//
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "catch.hpp"
+#include "Allocator.hpp"
+#include "Relocation.hpp"
+
+namespace {
+    struct Point { float x, y, z; };
+
+    // counts live instances to check which paths run destructors
+    struct Tracked {
+        static int live;
+        int value;
+        Tracked(int v = 0) : value(v) { ++live; }
+        Tracked(Tracked&& other) : value(other.value) { ++live; }
+        Tracked(const Tracked& other) : value(other.value) { ++live; }
+        ~Tracked(){ --live; }
+    };
+    int Tracked::live = 0;
+
+    struct MoveOnly {
+        std::unique_ptr<int> value;
+        MoveOnly(std::unique_ptr<int> v) : value(std::move(v)) {}
+    };
+}
+
+static_assert(is_trivially_relocatable<Point>::value, "trivially copyable types relocate with memcpy");
+static_assert(!is_trivially_relocatable<std::string>::value, "std::string may point into itself");
+
+TEST_CASE("RelocationHelpers","[relocation]"){
+
+    alignas(Point) char raw[sizeof(Point) * 64];
+    auto points = reinterpret_cast<Point*>(raw);
+    std::memset(raw, 0xFF, sizeof(raw));
+    construct_n(points, 64);
+    REQUIRE(points[63].x == 0.0f);
+    construct_n(points, 64, Point{1, 2, 3});
+    REQUIRE(points[10].z == 3.0f);
+
+    // overlapping relocation in both directions
+    for(int i = 0; i < 64; i++){ points[i].x = float(i); }
+    relocate_n(points + 8, 16, points + 4);
+    REQUIRE(points[4].x == 8.0f);
+    REQUIRE(points[19].x == 23.0f);
+    relocate_n(points, 16, points + 2);
+    REQUIRE(points[2].x == 0.0f);
+    REQUIRE(points[17].x == 19.0f);
+    destroy_n(points, 64);
+
+    alignas(Tracked) char trackedRaw[sizeof(Tracked) * 16];
+    auto tracked = reinterpret_cast<Tracked*>(trackedRaw);
+    construct_n(tracked, 8);
+    REQUIRE(Tracked::live == 8);
+    for(int i = 0; i < 8; i++){ tracked[i].value = i; }
+    relocate_n(tracked, 8, tracked + 4);
+    REQUIRE(Tracked::live == 8);
+    REQUIRE(tracked[4].value == 0);
+    REQUIRE(tracked[11].value == 7);
+    destroy_n(tracked + 4, 8);
+    REQUIRE(Tracked::live == 0);
+}
+
+TEST_CASE("InitializerForwarding","[relocation]"){
+
+    // construct forwards, so move only arguments are accepted and nothing is copied
+    Allocator<MoveOnly> alloc;
+    auto ptr = alloc.allocate(1);
+    alloc.construct(ptr, std::unique_ptr<int>(new int(42)));
+    REQUIRE(*ptr->value == 42);
+    alloc.destroy(ptr);
+    alloc.deallocate(ptr, 1);
+
+    Allocator<Tracked> tracked;
+    auto many = tracked.allocate(32);
+    tracked.construct_n(many, 32);
+    REQUIRE(Tracked::live == 32);
+    tracked.destroy_n(many, 32);
+    REQUIRE(Tracked::live == 0);
+    tracked.deallocate(many, 32);
+}
@@ -0,0 +1,85 @@
+//
+//  test-SizeClassAllocator.cpp
+//  MemoryManagement
+//
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "catch.hpp"
+#include "Allocator.hpp"
+#include "FreeStoreAllocator.hpp"
+#include "SizeClassAllocator.hpp"
+
+TEST_CASE("SizeClassTable","[allocator]"){
+
+    REQUIRE(SizeClasses::index(1) == 0);
+    REQUIRE(SizeClasses::index(8) == 0);
+    REQUIRE(SizeClasses::index(9) == 1);
+    REQUIRE(SizeClasses::size(SizeClasses::index(128)) == 128);
+    REQUIRE(SizeClasses::size(SizeClasses::index(129)) == 160);
+    REQUIRE(SizeClasses::size(SizeClasses::index(257)) == 320);
+    REQUIRE(SizeClasses::size(SizeClasses::index(1000)) == 1024);
+
+    // every size maps to the smallest class that holds it
+    for(size_t bytes = 1; bytes <= SizeClasses::MAX_SIZE; bytes++){
+        auto index = SizeClasses::index(bytes);
+        REQUIRE(SizeClasses::size(index) >= bytes);
+        if(index > 0){
+            REQUIRE(SizeClasses::size(index - 1) < bytes);
+        }
+    }
+}
+
+TEST_CASE("SizeClassStoreSharing","[allocator]"){
+
+    auto store = SizeClassStore<>::get();
+
+    // an array of five 8 byte values lands in the same pool as a 40 byte object
+    struct Forty { char bytes[40]; };
+    using Alloc = Allocator<Forty, FreeStoreAllocator<Forty, BlockListStorage, 65536>>;
+    Alloc alloc;
+
+    auto array = store->allocate(5 * sizeof(uint64_t));
+    store->deallocate(array, 5 * sizeof(uint64_t));
+    auto object = alloc.allocate();
+    REQUIRE(static_cast<void*>(object) == array);
+    alloc.deallocate(object);
+
+    // sizes in the same class reuse each other's slots
+    auto small = store->allocate(33);
+    store->deallocate(small, 33);
+    REQUIRE(store->allocate(38) == small);
+    store->deallocate(small, 38);
+
+    REQUIRE(store->store(2048) == nullptr);
+    auto large = store->allocate(2048);
+    REQUIRE(large != nullptr);
+    store->deallocate(large, 2048);
+}
+
+TEST_CASE("SizeClassAllocatorContainers","[allocator]"){
+
+    std::vector<int, Allocator<int, SizeClassAllocator<int>>> numbers;
+    for(int i = 0; i < 1000; i++){
+        numbers.push_back(i);
+    }
+    for(int i = 0; i < 1000; i++){
+        REQUIRE(numbers[i] == i);
+    }
+
+    using String = std::basic_string<char, std::char_traits<char>, Allocator<char, SizeClassAllocator<char>>>;
+    String text;
+    for(int i = 0; i < 100; i++){
+        text += "pooled ";
+    }
+    REQUIRE(text.size() == 700);
+
+    using Pair = std::pair<const int, String>;
+    std::unordered_map<int, String, std::hash<int>, std::equal_to<int>, Allocator<Pair, SizeClassAllocator<Pair>>> map;
+    for(int i = 0; i < 100; i++){
+        map.emplace(i, String(i % 10, 'x'));
+    }
+    REQUIRE(map.size() == 100);
+    REQUIRE(map[42].size() == 2);
+}
@@ -0,0 +1,95 @@
+//
+//  test-SlabStore.cpp
+//  MemoryManagement
+//
+
+#include <chrono>
+#include <iostream>
+#include <set>
+#include <vector>
+#include "catch.hpp"
+#include "Allocator.hpp"
+#include "FreeStoreAllocator.hpp"
+#include "SlabStore.hpp"
+
+TEST_CASE("SlabStoreBitmap","[slab]"){
+
+    using Store = SlabStore<40, 4096>;
+    REQUIRE(Store::OBJECTS_OFFSET % CACHE_LINE_SIZE == 0);
+    REQUIRE(Store::OBJECTS_OFFSET + Store::OBJECTS_PER_SLAB * Store::OBJECT_SIZE <= 4096);
+    auto store = Store::get();
+
+    std::vector<void*> slots;
+    for(size_t i = 0; i < Store::OBJECTS_PER_SLAB * 3 + 5; i++){
+        slots.push_back(store->allocate());
+        std::memset(slots.back(), 0xAB, 40);
+    }
+    REQUIRE(std::set<void*>(slots.begin(), slots.end()).size() == slots.size());
+    REQUIRE(store->capacity() == Store::OBJECTS_PER_SLAB * 4);
+    REQUIRE(store->live() == slots.size());
+
+    // freed objects are left untouched and their slot is the next one handed out
+    store->deallocate(slots[7]);
+    REQUIRE_FALSE(store->is_live(slots[7]));
+    REQUIRE(static_cast<unsigned char*>(slots[7])[0] == 0xAB);
+    REQUIRE(store->allocate() == slots[7]);
+    REQUIRE(store->is_live(slots[7]));
+
+    // a full slab becomes available again as soon as one of its objects is freed
+    store->deallocate(slots[Store::OBJECTS_PER_SLAB + 2]);
+    REQUIRE(store->allocate() == slots[Store::OBJECTS_PER_SLAB + 2]);
+
+    for(auto slot : slots){ store->deallocate(slot); }
+    REQUIRE(store->live() == 0);
+}
+
+TEST_CASE("SlabStoreForEachLive","[slab]"){
+
+    struct Particle { float position[3]; float velocity[3]; uint32_t id; };
+    using Alloc = Allocator<Particle, FreeStoreAllocator<Particle, BlockListStorage, 65536, SlabFreeStore>>;
+    auto store = Alloc::Policy::store_type::get();
+
+    Alloc alloc;
+    std::vector<Particle*> particles;
+    for(uint32_t i = 0; i < 10000; i++){
+        particles.push_back(alloc.allocate());
+        alloc.construct(particles.back());
+        particles.back()->id = i;
+    }
+    // leave a sparse set alive, including long empty runs
+    std::set<uint32_t> expected;
+    for(uint32_t i = 0; i < particles.size(); i++){
+        if(i % 97 == 0 || (i > 5000 && i < 5010)){
+            expected.insert(i);
+        }else{
+            alloc.deallocate(particles[i]);
+        }
+    }
+
+    std::set<uint32_t> seen;
+    store->for_each_live([&seen](void* ptr){
+        seen.insert(static_cast<Particle*>(ptr)->id);
+    });
+    REQUIRE(seen == expected);
+}
+
+TEST_CASE("SlabStoreSweep","[.][benchmark]"){
+
+    using Store = SlabStore<32>;
+    auto store = Store::get();
+    const size_t objects = 1000000;
+    std::vector<void*> slots(objects);
+    for(auto& slot : slots){ slot = store->allocate(); }
+    // one object in a hundred stays alive
+    for(size_t i = 0; i < objects; i++){
+        if(i % 100) store->deallocate(slots[i]);
+    }
+
+    size_t visited = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(int pass = 0; pass < 100; pass++){
+        store->for_each_live([&visited](void*){ ++visited; });
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "for_each_live: " << visited / elapsed / 1e6 << " M objects/s over " << store->capacity() << " slots" << std::endl;
+}
@@ -0,0 +1,74 @@
+//
+//  test-StackAllocator.cpp
+//  MemoryManagement
+//
+
+#include <vector>
+#include "catch.hpp"
+#include "Allocator.hpp"
+#include "StackAllocator.hpp"
+
+TEST_CASE("StackScopes","[stack]"){
+
+    Stack stack(4096);
+
+    auto outer = static_cast<char*>(stack.allocate(100));
+    {
+        Stack::Scope scope(stack);
+        auto inner = stack.allocate(200, 64);
+        REQUIRE(reinterpret_cast<uintptr_t>(inner) % 64 == 0);
+        REQUIRE(stack.used() > 300);
+
+        // popping the top allocation frees it straight away
+        auto top = stack.allocate(50);
+        stack.deallocate(top, 50);
+        REQUIRE(stack.allocate(50) == top);
+    }
+    REQUIRE(stack.used() == 100);
+    REQUIRE(stack.allocate(8, 4) == outer + 100);
+    REQUIRE(stack.high_water_mark() > 300);
+
+    REQUIRE_THROWS_AS(stack.allocate(8192), std::bad_alloc);
+    stack.reset();
+    REQUIRE(stack.used() == 0);
+}
+
+TEST_CASE("StackAllocatorVector","[stack]"){
+
+    Stack stack(64 * 1024);
+    using IntAlloc = Allocator<int, StackAllocator<int>>;
+    {
+        Stack::Scope scope(stack);
+        std::vector<int, IntAlloc> values{IntAlloc(stack)};
+        for(int i = 0; i < 1000; i++){
+            values.push_back(i);
+        }
+        REQUIRE(values[999] == 999);
+    }
+    REQUIRE(stack.used() == 0);
+    REQUIRE(stack.high_water_mark() >= 1000 * sizeof(int));
+}
+
+TEST_CASE("FrameAllocator","[stack]"){
+
+    FrameStacks frames(16 * 1024);
+    using IntAlloc = Allocator<int, FrameAllocator<int>>;
+    IntAlloc alloc(frames);
+
+    auto last = alloc.allocate(4);
+    last[0] = 7;
+    for(int tick = 1; tick < 10; tick++){
+        frames.flip();
+        REQUIRE(frames.frame() == size_t(tick));
+
+        // last frame's data is still intact while this frame allocates
+        std::vector<int, IntAlloc> scratch{alloc};
+        scratch.resize(tick * 100, tick);
+        REQUIRE(last[0] == tick + 6);
+
+        last = alloc.allocate(4);
+        last[0] = tick + 7;
+        REQUIRE(frames.current().used() > 0);
+    }
+    REQUIRE(frames.high_water_mark() >= 900 * sizeof(int));
+}
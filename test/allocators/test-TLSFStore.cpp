@@ -0,0 +1,121 @@
+//
+//  test-TLSFStore.cpp
+//  MemoryManagement
+//
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "catch.hpp"
+#include "Heap.hpp"
+#include "LatencyRecorder.hpp"
+#include "TLSFStore.hpp"
+
+TEST_CASE("TLSFStoreSplitMerge","[tlsf]"){
+
+    using Store = TLSFStore<64 * 1024>;
+    auto store = Store::get();
+    const auto empty = store->capacity();
+    REQUIRE(empty == 64 * 1024 - 16);
+
+    auto first = static_cast<char*>(store->allocate(100));
+    auto second = static_cast<char*>(store->allocate(1));
+    auto third = static_cast<char*>(store->allocate(5000));
+    REQUIRE(reinterpret_cast<uintptr_t>(first) % Store::ALIGNMENT == 0);
+    REQUIRE(reinterpret_cast<uintptr_t>(second) % Store::ALIGNMENT == 0);
+    // blocks are carved back to back, each behind its own header
+    REQUIRE(second == first + 112 + 16);
+    REQUIRE(third == second + 16 + 16);
+
+    // freeing the middle block and then its neighbours coalesces everything
+    store->deallocate(second);
+    REQUIRE(store->allocate(8) == second);
+    store->deallocate(second);
+    store->deallocate(first);
+    store->deallocate(third);
+    REQUIRE(store->capacity() == empty);
+
+    // searches round up to the next bin, so a request only just fitting the pool fails
+    auto most = store->allocate(40000);
+    REQUIRE_THROWS_AS(store->allocate(40000), std::bad_alloc);
+    REQUIRE_THROWS_AS(store->allocate(empty), std::bad_alloc);
+    store->deallocate(most);
+    REQUIRE(store->capacity() == empty);
+}
+
+TEST_CASE("TLSFStoreRandom","[tlsf]"){
+
+    using Store = TLSFStore<16 * 1024 * 1024>;
+    auto store = Store::get();
+    const auto empty = store->capacity();
+    std::mt19937 random(3);
+
+    struct Block { unsigned char* ptr; size_t size; unsigned char fill; };
+    std::vector<Block> blocks;
+    for(int round = 0; round < 20000; round++){
+        if(blocks.empty() || random() % 2 == 0){
+            size_t size = 1 + random() % (random() % 8 ? 256 : 64 * 1024);
+            auto fill = static_cast<unsigned char>(round);
+            auto ptr = static_cast<unsigned char*>(store->allocate(size));
+            REQUIRE(reinterpret_cast<uintptr_t>(ptr) % Store::ALIGNMENT == 0);
+            std::memset(ptr, fill, size);
+            blocks.push_back(Block{ptr, size, fill});
+        }else{
+            std::swap(blocks[random() % blocks.size()], blocks.back());
+            auto& block = blocks.back();
+            REQUIRE(block.ptr[0] == block.fill);
+            REQUIRE(block.ptr[block.size - 1] == block.fill);
+            store->deallocate(block.ptr);
+            blocks.pop_back();
+        }
+    }
+    std::shuffle(blocks.begin(), blocks.end(), random);
+    for(auto& block : blocks){
+        REQUIRE(block.ptr[block.size / 2] == block.fill);
+        store->deallocate(block.ptr);
+    }
+    REQUIRE(store->capacity() == empty);
+}
+
+TEST_CASE("TLSFStoreWorstCase","[.][benchmark]"){
+
+    const size_t operations = 1000000;
+    const size_t live = 4096;
+    std::mt19937 random(5);
+    std::vector<size_t> sizes(operations);
+    for(auto& size : sizes){ size = 16 + random() % (random() % 16 ? 1024 : 64 * 1024); }
+    std::vector<size_t> victims(operations);
+    for(auto& victim : victims){ victim = random() % live; }
+
+    // every call is timed, the tail is what matters here
+    auto run = [&](const char* label, IAllocator* allocator){
+        LatencyHistogram allocations, deallocations;
+        std::vector<void*> slots(live, nullptr);
+        for(size_t i = 0; i < operations; i++){
+            auto& slot = slots[victims[i]];
+            if(slot){
+                auto start = LatencyRecorder::now();
+                allocator->deallocate(slot);
+                deallocations.record(LatencyRecorder::now() - start);
+            }
+            auto start = LatencyRecorder::now();
+            slot = allocator->allocate(sizes[i]);
+            allocations.record(LatencyRecorder::now() - start);
+            static_cast<char*>(slot)[0] = 1;
+        }
+        for(auto slot : slots){ if(slot) allocator->deallocate(slot); }
+        for(auto& entry : {std::make_pair("allocate", &allocations), std::make_pair("deallocate", &deallocations)}){
+            auto& histogram = *entry.second;
+            std::cout << label << " " << entry.first << " ns: p50=" << histogram.percentile(50)
+                      << " p99=" << histogram.percentile(99) << " p99.9=" << histogram.percentile(99.9)
+                      << " p99.99=" << histogram.percentile(99.99) << " max=" << histogram.max() << std::endl;
+        }
+    };
+
+    run("Heap<1>", Heap<1>::get());
+    auto tlsf = TLSFStore<size_t(256) * 1024 * 1024>::get();
+    tlsf->prefault();
+    run("TLSFStore", tlsf);
+}
@@ -0,0 +1,154 @@
+//
+//  test-ThreadRangeFreeStore.cpp
+//  MemoryManagement
+//
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <set>
+#include <thread>
+#include <vector>
+#include "catch.hpp"
+#include "Allocator.hpp"
+#include "FreeStoreAllocator.hpp"
+#include "ThreadRangeFreeStore.hpp"
+
+namespace {
+
+struct Counter { std::atomic<uint64_t> value{0}; };
+
+size_t line(const void* ptr){ return reinterpret_cast<uintptr_t>(ptr) / CACHE_LINE_SIZE; }
+
+}
+
+TEST_CASE("PaddedStorage","[storage]"){
+
+    using Storage = PaddedBlockListStorage<sizeof(Counter), 4096>;
+    REQUIRE(Storage::OBJECT_SIZE == CACHE_LINE_SIZE);
+
+    Storage storage;
+    for(size_t i = 1; i < Storage::OBJECTS_PER_BLOCK; i++){
+        REQUIRE(line(storage[i]) == line(storage[i - 1]) + 1);
+        REQUIRE(reinterpret_cast<uintptr_t>(storage[i]) % CACHE_LINE_SIZE == 0);
+    }
+}
+
+TEST_CASE("ThreadRangeFreeStoreLines","[allocator]"){
+
+    using Store = ThreadRangeFreeStore<24, BlockListStorage<24, 4096>>;
+    REQUIRE(Store::LINE_PERIOD == 8);
+    REQUIRE(Store::RUN_OBJECTS % Store::LINE_PERIOD == 0);
+
+    const size_t numThreads = 4;
+    std::vector<std::vector<void*>> slots(numThreads);
+    std::atomic<size_t> done{0};
+    std::atomic<size_t> reused{0};
+    std::vector<std::thread> threads;
+    for(size_t t = 0; t < numThreads; t++){
+        threads.emplace_back([&slots, &done, &reused, t, numThreads]{
+            auto store = Store::get();
+            for(int i = 0; i < 300; i++){
+                slots[t].push_back(store->allocate());
+            }
+            // freed slots stay with this thread
+            store->deallocate(slots[t][10]);
+            if(store->allocate() == slots[t][10]) reused++;
+            // stay alive so no thread adopts another's leftovers
+            done++;
+            while(done < numThreads){ std::this_thread::yield(); }
+        });
+    }
+    for(auto& thread : threads){ thread.join(); }
+    REQUIRE(reused == numThreads);
+
+    // no line is touched by two threads
+    std::set<size_t> lines;
+    for(auto& threadSlots : slots){
+        std::set<size_t> own;
+        for(auto slot : threadSlots){
+            own.insert(line(slot));
+            own.insert(line(static_cast<char*>(slot) + 23));
+        }
+        for(auto l : own){
+            REQUIRE(lines.insert(l).second);
+        }
+    }
+
+    // what an exited thread held is picked up by the next one: a slot of some thread's last run
+    // it never handed out, with no fresh run carved from the storage
+    const ptrdiff_t size = BlockListStorage<24, 4096>::OBJECT_SIZE;
+    std::set<void*> previous;
+    std::vector<std::pair<char*, char*>> leftovers;
+    for(auto& threadSlots : slots){
+        previous.insert(threadSlots.begin(), threadSlots.end());
+        size_t start = threadSlots.size() - 1;
+        while(start > 0 && static_cast<char*>(threadSlots[start]) - static_cast<char*>(threadSlots[start - 1]) == size){ --start; }
+        auto run = static_cast<char*>(threadSlots[start]);
+        leftovers.emplace_back(static_cast<char*>(threadSlots.back()) + size, run + Store::RUN_OBJECTS * size);
+    }
+    auto capacity = Store::get()->capacity();
+    void* adopted = nullptr;
+    std::thread([&adopted]{ adopted = Store::get()->allocate(); }).join();
+    REQUIRE(previous.count(adopted) == 0);
+    REQUIRE(Store::get()->capacity() == capacity);
+    auto inLeftovers = std::any_of(leftovers.begin(), leftovers.end(), [adopted](const std::pair<char*, char*>& range){
+        return adopted >= range.first && adopted < range.second;
+    });
+    REQUIRE(inLeftovers);
+}
+
+TEST_CASE("FalseSharingCounters","[.][benchmark]"){
+
+    const size_t numThreads = std::max(2u, std::thread::hardware_concurrency());
+    const size_t countersPerThread = 8;
+    const size_t iterations = 10000000;
+
+    // each thread bumps its own counters, only the layout differs
+    auto run = [&](const char* label, std::function<Counter*(size_t)> make){
+        std::vector<std::vector<Counter*>> counters(numThreads);
+        for(size_t i = 0; i < countersPerThread; i++){
+            for(size_t t = 0; t < numThreads; t++){
+                counters[t].push_back(make(t));
+            }
+        }
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for(size_t t = 0; t < numThreads; t++){
+            threads.emplace_back([&counters, t, iterations, countersPerThread]{
+                auto& own = counters[t];
+                for(size_t i = 0; i < iterations; i++){
+                    auto& value = own[i % countersPerThread]->value;
+                    value.store(value.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                }
+            });
+        }
+        for(auto& thread : threads){ thread.join(); }
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << label << ": " << (numThreads * iterations) / elapsed / 1e6 << " Mincrements/s" << std::endl;
+    };
+
+    // interleaved allocation puts neighbouring counters in different threads
+    Allocator<Counter, FreeStoreAllocator<Counter, BlockListStorage, 65536>> packed;
+    run("packed", [&packed](size_t){ auto ptr = packed.allocate(); packed.construct(ptr); return ptr; });
+
+    Allocator<Counter, FreeStoreAllocator<Counter, PaddedBlockListStorage, 65536>> padded;
+    run("padded", [&padded](size_t){ auto ptr = padded.allocate(); padded.construct(ptr); return ptr; });
+
+    // each thread allocates its own counters from its own lines
+    using Store = ThreadRangeFreeStore<sizeof(Counter), BlockListStorage<sizeof(Counter), 65536>>;
+    std::vector<std::vector<Counter*>> owned(numThreads);
+    std::vector<std::thread> threads;
+    for(size_t t = 0; t < numThreads; t++){
+        threads.emplace_back([&owned, t, countersPerThread]{
+            for(size_t i = 0; i < countersPerThread; i++){
+                owned[t].push_back(new(Store::get()->allocate()) Counter);
+            }
+        });
+    }
+    for(auto& thread : threads){ thread.join(); }
+    std::vector<size_t> next(numThreads, 0);
+    run("thread ranges", [&owned, &next](size_t t){ return owned[t][next[t]++]; });
+}